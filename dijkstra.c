@@ -1,11 +1,57 @@
 #include "dijkstra.h"
+
+#include <limits.h>
+
+#include "memstat.h"
 /*
  * Dijkstra's algorithm
  *
- * Implements a straightforward O(V^2 + E) version using arrays instead of a
- * heap for simplicity and portability. Reconstructs the actual shortest path
- * and returns it to the caller.
+ * Public entry points over one generic search kernel (dijkstra_kernel.h),
+ * specialized at compile time for distance type (int or long long), queue
+ * policy (linear scan or binary heap) and output (path or distance only).
+ * The default is the original O(V^2 + E) array implementation, which serves
+ * as the reference engine; 64-bit variants answer routes too long for int.
+ */
+
+// Reference engine: int distances, linear scan, full path
+#define KERNEL_NAME kernel_int_linear_path
+#define KERNEL_DIST int
+#define KERNEL_INF INF_DISTANCE
+#define KERNEL_HEAP 0
+#define KERNEL_PATH 1
+#include "dijkstra_kernel.h"
+
+// Distance-only queries: int distances, linear scan, no predecessors
+#define KERNEL_NAME kernel_int_linear_distance
+#define KERNEL_DIST int
+#define KERNEL_INF INF_DISTANCE
+#define KERNEL_HEAP 0
+#define KERNEL_PATH 0
+#include "dijkstra_kernel.h"
+
+// Long routes: 64-bit distances, heap, full path
+#define KERNEL_NAME kernel_wide_heap_path
+#define KERNEL_DIST long long
+#define KERNEL_INF LLONG_MAX
+#define KERNEL_HEAP 1
+#define KERNEL_PATH 1
+#include "dijkstra_kernel.h"
+
+// Long distance-only queries: 64-bit distances, linear scan, no predecessors
+#define KERNEL_NAME kernel_wide_linear_distance
+#define KERNEL_DIST long long
+#define KERNEL_INF LLONG_MAX
+#define KERNEL_HEAP 0
+#define KERNEL_PATH 0
+#include "dijkstra_kernel.h"
+
+/*
+ * valid_query
+ * 	Shared argument check for the public entry points.
  */
+static int valid_query(const Graph *graph, int src, int dst) {
+	return graph != NULL && src >= 0 && src < graph->numVertices && dst >= 0 && dst < graph->numVertices;
+}
 
 /* 
  * dijkstra_shortest_path
@@ -21,118 +67,49 @@
  * Returns:
  * 	>0 if a path is found,
  * 	0  if no path exists,
+ * 	DIJKSTRA_TOO_LONG if a path may exist but only at INF_DISTANCE or more,
  * 	-1 on invalid input or allocation failure.
  *
  * Notes:
  * 	Caller owns and must free(*outPath) when return value > 0.
  */
 int dijkstra_shortest_path(const Graph *graph, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance) {
-	if (graph == NULL || outPath == NULL || outPathLen == NULL || outTotalDistance == NULL) {
-		return -1;
-	}
-	int n = graph->numVertices;
-	if (src < 0 || src >= n || dst < 0 || dst >= n) {
+	if (!valid_query(graph, src, dst) || outPath == NULL || outPathLen == NULL || outTotalDistance == NULL) {
 		return -1;
 	}
+	return kernel_int_linear_path(graph, src, dst, outTotalDistance, outPath, outPathLen);
+}
 
-	int *distance = (int *)malloc((size_t)n * sizeof(int));
-	int *visited = (int *)malloc((size_t)n * sizeof(int));
-	int *previous = (int *)malloc((size_t)n * sizeof(int));
-	if (distance == NULL || visited == NULL || previous == NULL) {
-		free(distance);
-		free(visited);
-		free(previous);
+/* 
+ * dijkstra_distance
+ * 	Shortest distance only: the same linear scan as dijkstra_shortest_path
+ * 	without a predecessor array or path.
+ */
+int dijkstra_distance(const Graph *graph, int src, int dst, int *outTotalDistance) {
+	if (!valid_query(graph, src, dst) || outTotalDistance == NULL) {
 		return -1;
 	}
-	for (int i = 0; i < n; i++) {
-		distance[i] = INF_DISTANCE;
-		visited[i] = 0;
-		previous[i] = -1;
-	}
-	distance[src] = 0;
-
-	// O(V^2 + E) implementation without a heap for simplicity and portability
-	for (int iter = 0; iter < n; iter++) {
-		int u = -1;
-		int best = INF_DISTANCE;
-		for (int i = 0; i < n; i++) {
-			if (!visited[i] && distance[i] < best) {
-				best = distance[i];
-				u = i;
-			}
-		}
-		if (u == -1) {
-			break; // remaining vertices unreachable
-		}
-		visited[u] = 1;
-		if (u == dst) {
-			break;
-		}
-		for (Edge *e = graph->adjacency[u]; e != NULL; e = e->next) {
-			int v = e->to;
-			int w = e->weight;
-			if (!visited[v] && distance[u] + w < distance[v]) {
-				distance[v] = distance[u] + w;
-				previous[v] = u;
-			}
-		}
-	}
-
-	if (distance[dst] >= INF_DISTANCE) {
-		free(distance);
-		free(visited);
-		free(previous);
-		return 0; // not found
-	}
+	return kernel_int_linear_distance(graph, src, dst, outTotalDistance);
+}
 
-	// Reconstruct path from dst back to src
-	int pathCapacity = 16;
-	int pathSize = 0;
-	int *revPath = (int *)malloc((size_t)pathCapacity * sizeof(int));
-	if (revPath == NULL) {
-		free(distance);
-		free(visited);
-		free(previous);
+/* 
+ * dijkstra_shortest_path_wide
+ * 	64-bit variant of dijkstra_shortest_path on a binary heap.
+ */
+int dijkstra_shortest_path_wide(const Graph *graph, int src, int dst, int **outPath, int *outPathLen, long long *outTotalDistance) {
+	if (!valid_query(graph, src, dst) || outPath == NULL || outPathLen == NULL || outTotalDistance == NULL) {
 		return -1;
 	}
-	for (int cur = dst; cur != -1; cur = previous[cur]) {
-		if (pathSize >= pathCapacity) {
-			pathCapacity *= 2;
-			int *tmp = (int *)realloc(revPath, (size_t)pathCapacity * sizeof(int));
-			if (tmp == NULL) {
-				free(revPath);
-				free(distance);
-				free(visited);
-				free(previous);
-				return -1;
-			}
-			revPath = tmp;
-		}
-		revPath[pathSize++] = cur;
-	}
+	return kernel_wide_heap_path(graph, src, dst, outTotalDistance, outPath, outPathLen);
+}
 
-	// Reverse into output order src -> dst
-	int *path = (int *)malloc((size_t)pathSize * sizeof(int));
-	if (path == NULL) {
-		free(revPath);
-		free(distance);
-		free(visited);
-		free(previous);
+/* 
+ * dijkstra_distance_wide
+ * 	Shortest distance only, with 64-bit sums and the reference linear scan.
+ */
+int dijkstra_distance_wide(const Graph *graph, int src, int dst, long long *outTotalDistance) {
+	if (!valid_query(graph, src, dst) || outTotalDistance == NULL) {
 		return -1;
 	}
-	for (int i = 0; i < pathSize; i++) {
-		path[i] = revPath[pathSize - 1 - i];
-	}
-
-	*outPath = path;
-	*outPathLen = pathSize;
-	*outTotalDistance = distance[dst];
-
-	free(revPath);
-	free(distance);
-	free(visited);
-	free(previous);
-	return 1;
+	return kernel_wide_linear_distance(graph, src, dst, outTotalDistance);
 }
-
-
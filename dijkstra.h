@@ -3,9 +3,18 @@
 
 #include "graph.h"
 
-// Constant used for "infinite" distance in Dijkstra's algorithm.
+// Constant used for "infinite" distance in Dijkstra's algorithm. The int
+// searches treat any route of this length or more as unreachable; use the
+// *_wide variants for longer routes.
 #define INF_DISTANCE 1000000000
 
+// Returned instead of 0 when the overflow guard skipped an edge because the
+// sum would have reached the distance type's "infinite" value: dst may then
+// be reachable, but only by a route too long for the type (INF_DISTANCE or
+// more for int searches). Retry with a *_wide variant; a plain 0 means dst is
+// unreachable at any length.
+#define DIJKSTRA_TOO_LONG (-2)
+
 // dijkstra_shortest_path:
 //   Finds the shortest path from src to dst using Dijkstra's algorithm on an
 //   adjacency-list graph. This implementation uses a linear scan to select the
@@ -19,9 +28,33 @@
 // Returns:
 //   1  if a path is found (outPath/outPathLen/outTotalDistance set)
 //   0  if no path exists
+//   DIJKSTRA_TOO_LONG if any path would be INF_DISTANCE or longer
 //  -1  on invalid input or allocation failure
 int dijkstra_shortest_path(const Graph *graph, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance);
 
+// dijkstra_distance:
+//   Shortest distance only, using the same linear scan as
+//   dijkstra_shortest_path; no predecessor array is kept.
+// Returns:
+//   1 if dst is reachable (*outTotalDistance set), 0 if not,
+//   DIJKSTRA_TOO_LONG if any route would be INF_DISTANCE or longer,
+//  -1 on invalid input or allocation failure.
+int dijkstra_distance(const Graph *graph, int src, int dst, int *outTotalDistance);
+
+// dijkstra_shortest_path_wide:
+//   Same contract as dijkstra_shortest_path, but sums distances in 64 bits
+//   (no INF_DISTANCE limit) and selects vertices with a binary heap,
+//   O((V + E) log V).
+int dijkstra_shortest_path_wide(const Graph *graph, int src, int dst, int **outPath, int *outPathLen, long long *outTotalDistance);
+
+// dijkstra_distance_wide:
+//   64-bit variant of dijkstra_distance.
+// Returns:
+//   1 if dst is reachable (*outTotalDistance set), 0 if not,
+//   DIJKSTRA_TOO_LONG past LLONG_MAX, -1 on invalid input or allocation
+//   failure.
+int dijkstra_distance_wide(const Graph *graph, int src, int dst, long long *outTotalDistance);
+
 #endif
 
 
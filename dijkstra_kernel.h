@@ -0,0 +1,336 @@
+/*
+ * Dijkstra search kernel (template)
+ *
+ * Included once per specialization by dijkstra.c (per-call searches) and
+ * search.c (workspace searches); deliberately has no include guard. Before
+ * each inclusion define:
+ *
+ * 	KERNEL_NAME       name of the generated static function
+ * 	KERNEL_DIST       distance type: int or long long
+ * 	KERNEL_INF        "unreached" value of KERNEL_DIST; distances at or above
+ * 	                  it are treated as unreachable, so sums can never overflow
+ * 	KERNEL_HEAP       1: binary min-heap with lazy deletion, O((V + E) log V)
+ * 	                  0: linear select-min scan, O(V^2 + E)
+ * 	KERNEL_PATH       1: record predecessors and return the path
+ * 	                  0: distance only; no previous[] array is allocated or written
+ *
+ * and optionally:
+ *
+ * 	KERNEL_WORKSPACE  1: run in a caller's SearchWorkspace (int distances and a
+ * 	                  heap only). Only the entries a search touched are reset
+ * 	                  afterwards, and the heap and touched list grow on demand
+ * 	                  through the includer's touch, grow_heap, ensure_previous
+ * 	                  and reset_workspace. 0 (default): scratch is allocated
+ * 	                  per call and charged to MEM_SCRATCH.
+ * 	KERNEL_VISIT      range mode (requires KERNEL_WORKSPACE): name of a function
+ * 	                  int f(void *context, int vertex, KERNEL_DIST distance,
+ * 	                  int parent) called once per settled vertex, src included,
+ * 	                  in non-decreasing distance order. parent is the
+ * 	                  predecessor with KERNEL_PATH and -1 otherwise. It returns
+ * 	                  1 to relax the vertex's edges, 0 to settle it without
+ * 	                  relaxing them (pruning) and -1 to abort the search.
+ *
+ * Every choice is resolved by the preprocessor, so the generated loops carry
+ * no runtime branches on them. The macros are #undef'd at the end.
+ *
+ * Generated function:
+ *
+ * 	static int KERNEL_NAME(const Graph *graph, int src, int dst,
+ * 		KERNEL_DIST *outTotalDistance[, int **outPath, int *outPathLen]);
+ *
+ * with 'SearchWorkspace *ws' in place of 'graph' for workspace searches.
+ * Arguments are validated by the public wrappers. Returns 1 if dst is
+ * reachable, 0 if not, DIJKSTRA_TOO_LONG if it was not reached but the
+ * overflow guard skipped an edge on the way, -1 on allocation failure.
+ * *outPath is malloc'd and owned by the caller.
+ *
+ * Range mode generates instead
+ *
+ * 	static int KERNEL_NAME(SearchWorkspace *ws, int src, KERNEL_DIST bound,
+ * 		void *visitContext);
+ *
+ * which settles every vertex within 'bound' (>= 0, below KERNEL_INF) of src
+ * and returns 1, 2 if edges leading past 'bound' were skipped, or -1 if the
+ * visitor aborted or an allocation failed.
+ */
+
+#ifndef KERNEL_WORKSPACE
+#define KERNEL_WORKSPACE 0
+#endif
+
+#if !defined(KERNEL_NAME) || !defined(KERNEL_DIST) || !defined(KERNEL_INF) || !defined(KERNEL_HEAP) || !defined(KERNEL_PATH)
+#error "dijkstra_kernel.h needs KERNEL_NAME, KERNEL_DIST, KERNEL_INF, KERNEL_HEAP and KERNEL_PATH"
+#endif
+#if KERNEL_WORKSPACE && !KERNEL_HEAP
+#error "workspace searches use the heap queue"
+#endif
+#if defined(KERNEL_VISIT) && !KERNEL_WORKSPACE
+#error "range searches run in a workspace"
+#endif
+
+#define KERNEL_JOIN_(a, b) a##_##b
+#define KERNEL_JOIN(a, b) KERNEL_JOIN_(a, b)
+#define KERNEL_FN(suffix) KERNEL_JOIN(KERNEL_NAME, suffix)
+
+#if KERNEL_HEAP
+/*
+ * <kernel>_heap_push
+ * 	Insert (vertex, key). The caller made room for it.
+ */
+static void KERNEL_FN(heap_push)(int *heapVertex, KERNEL_DIST *heapKey, int *heapSize, int vertex, KERNEL_DIST key) {
+	int i = (*heapSize)++;
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (heapKey[parent] <= key) {
+			break;
+		}
+		heapVertex[i] = heapVertex[parent];
+		heapKey[i] = heapKey[parent];
+		i = parent;
+	}
+	heapVertex[i] = vertex;
+	heapKey[i] = key;
+}
+
+/*
+ * <kernel>_heap_pop
+ * 	Remove the minimum into *outVertex / *outKey (heap must be non-empty).
+ */
+static void KERNEL_FN(heap_pop)(int *heapVertex, KERNEL_DIST *heapKey, int *heapSize, int *outVertex, KERNEL_DIST *outKey) {
+	*outVertex = heapVertex[0];
+	*outKey = heapKey[0];
+	int size = --(*heapSize);
+	if (size == 0) {
+		return;
+	}
+	int lastVertex = heapVertex[size];
+	KERNEL_DIST lastKey = heapKey[size];
+	int i = 0;
+	while (1) {
+		int child = 2 * i + 1;
+		if (child >= size) {
+			break;
+		}
+		if (child + 1 < size && heapKey[child + 1] < heapKey[child]) {
+			child++;
+		}
+		if (lastKey <= heapKey[child]) {
+			break;
+		}
+		heapVertex[i] = heapVertex[child];
+		heapKey[i] = heapKey[child];
+		i = child;
+	}
+	heapVertex[i] = lastVertex;
+	heapKey[i] = lastKey;
+}
+#endif
+
+#if defined(KERNEL_VISIT)
+static int KERNEL_NAME(SearchWorkspace *ws, int src, KERNEL_DIST bound, void *visitContext) {
+#else
+#if KERNEL_WORKSPACE
+static int KERNEL_NAME(SearchWorkspace *ws, int src, int dst, KERNEL_DIST *outTotalDistance
+#else
+static int KERNEL_NAME(const Graph *graph, int src, int dst, KERNEL_DIST *outTotalDistance
+#endif
+#if KERNEL_PATH
+	, int **outPath, int *outPathLen
+#endif
+	) {
+	// Every distance below KERNEL_INF fits; relaxations past it are flagged
+	KERNEL_DIST bound = KERNEL_INF - 1;
+#endif
+#if KERNEL_WORKSPACE
+	const Graph *graph = ws->graph;
+	KERNEL_DIST *distance = ws->distance;
+	int ok = 1;
+#if KERNEL_PATH
+	ok = ensure_previous(ws);
+	int *previous = ws->previous;
+#endif
+#define KERNEL_HEAP_ARGS ws->heapVertex, ws->heapKey, &ws->heapSize
+#define KERNEL_HEAP_SIZE ws->heapSize
+#else
+	int n = graph->numVertices;
+	size_t distanceBytes = (size_t)n * sizeof(KERNEL_DIST);
+	KERNEL_DIST *distance = (KERNEL_DIST *)mem_malloc(MEM_SCRATCH, distanceBytes);
+	unsigned char *done = (unsigned char *)mem_calloc(MEM_SCRATCH, (size_t)n, 1);
+	int ok = distance != NULL && done != NULL;
+#if KERNEL_PATH
+	int *previous = (int *)mem_malloc(MEM_SCRATCH, (size_t)n * sizeof(int));
+	ok = ok && previous != NULL;
+#endif
+#if KERNEL_HEAP
+	// Each relaxation pushes at most once per directed edge, plus the source
+	size_t heapCapacity = (size_t)graph->numEdges + 1;
+	int *heapVertex = (int *)mem_malloc(MEM_SCRATCH, heapCapacity * sizeof(int));
+	KERNEL_DIST *heapKey = (KERNEL_DIST *)mem_malloc(MEM_SCRATCH, heapCapacity * sizeof(KERNEL_DIST));
+	int heapSize = 0;
+	ok = ok && heapVertex != NULL && heapKey != NULL;
+#define KERNEL_HEAP_ARGS heapVertex, heapKey, &heapSize
+#define KERNEL_HEAP_SIZE heapSize
+#endif
+#endif
+
+	int found = -1;
+	int clipped = 0; // an edge led past 'bound'
+	if (ok) {
+#if KERNEL_WORKSPACE
+		ok = touch(ws, src, 0) && grow_heap(ws);
+#else
+		for (int i = 0; i < n; i++) {
+			distance[i] = KERNEL_INF;
+		}
+		distance[src] = 0;
+#endif
+#if KERNEL_PATH
+		previous[src] = -1;
+#endif
+#if KERNEL_HEAP
+		if (ok) {
+			KERNEL_FN(heap_push)(KERNEL_HEAP_ARGS, src, 0);
+		}
+		while (ok && KERNEL_HEAP_SIZE > 0) {
+			int u;
+			KERNEL_DIST du;
+			KERNEL_FN(heap_pop)(KERNEL_HEAP_ARGS, &u, &du);
+#if KERNEL_WORKSPACE
+			if (du > distance[u]) {
+				continue; // stale entry
+			}
+#else
+			if (done[u]) {
+				continue; // stale entry
+			}
+			done[u] = 1;
+#endif
+#else
+		for (int iter = 0; iter < n; iter++) {
+			int u = -1;
+			KERNEL_DIST du = KERNEL_INF;
+			for (int i = 0; i < n; i++) {
+				if (!done[i] && distance[i] < du) {
+					du = distance[i];
+					u = i;
+				}
+			}
+			if (u == -1) {
+				break; // remaining vertices unreachable
+			}
+			done[u] = 1;
+#endif
+#if defined(KERNEL_VISIT)
+#if KERNEL_PATH
+			int action = KERNEL_VISIT(visitContext, u, du, previous[u]);
+#else
+			int action = KERNEL_VISIT(visitContext, u, du, -1);
+#endif
+			if (action < 0) {
+				ok = 0;
+				break;
+			}
+			if (action == 0) {
+				continue; // settled, but its edges are pruned
+			}
+#else
+			if (u == dst) {
+				break;
+			}
+#endif
+			for (const Edge *e = graph->adjacency[u]; e != NULL; e = e->next) {
+				int v = e->to;
+#if !KERNEL_WORKSPACE
+				if (done[v]) {
+					continue;
+				}
+#endif
+				// Headroom test instead of a sum: du <= bound, so nothing overflows
+				if ((KERNEL_DIST)e->weight > bound - du) {
+					clipped = 1;
+					continue;
+				}
+				KERNEL_DIST candidate = du + e->weight;
+				if (candidate < distance[v]) {
+#if KERNEL_WORKSPACE
+					if (!touch(ws, v, candidate) || !grow_heap(ws)) {
+						ok = 0;
+						break;
+					}
+#else
+					distance[v] = candidate;
+#endif
+#if KERNEL_PATH
+					previous[v] = u;
+#endif
+#if KERNEL_HEAP
+					KERNEL_FN(heap_push)(KERNEL_HEAP_ARGS, v, candidate);
+#endif
+				}
+			}
+		}
+	}
+
+#if defined(KERNEL_VISIT)
+	if (ok) {
+		found = clipped ? 2 : 1;
+	}
+#else
+	if (ok) {
+		found = distance[dst] < KERNEL_INF;
+		if (found) {
+			*outTotalDistance = distance[dst];
+		} else if (clipped) {
+			found = DIJKSTRA_TOO_LONG;
+		}
+	}
+#if KERNEL_PATH
+	if (found > 0) {
+		// Count, then fill from the back: no reversal buffer needed
+		int pathSize = 0;
+		for (int cur = dst; cur != -1; cur = previous[cur]) {
+			pathSize++;
+		}
+		int *path = (int *)malloc((size_t)pathSize * sizeof(int));
+		if (path == NULL) {
+			found = -1;
+		} else {
+			int i = pathSize;
+			for (int cur = dst; cur != -1; cur = previous[cur]) {
+				path[--i] = cur;
+			}
+			*outPath = path;
+			*outPathLen = pathSize;
+		}
+	}
+#endif
+#endif
+
+#if KERNEL_WORKSPACE
+	reset_workspace(ws);
+#else
+	mem_free(MEM_SCRATCH, distance, distanceBytes);
+	mem_free(MEM_SCRATCH, done, (size_t)n);
+#if KERNEL_PATH
+	mem_free(MEM_SCRATCH, previous, (size_t)n * sizeof(int));
+#endif
+#if KERNEL_HEAP
+	mem_free(MEM_SCRATCH, heapVertex, heapCapacity * sizeof(int));
+	mem_free(MEM_SCRATCH, heapKey, heapCapacity * sizeof(KERNEL_DIST));
+#endif
+#endif
+	return found;
+}
+
+#undef KERNEL_HEAP_ARGS
+#undef KERNEL_HEAP_SIZE
+#undef KERNEL_FN
+#undef KERNEL_JOIN
+#undef KERNEL_JOIN_
+#undef KERNEL_NAME
+#undef KERNEL_DIST
+#undef KERNEL_INF
+#undef KERNEL_HEAP
+#undef KERNEL_PATH
+#undef KERNEL_WORKSPACE
+#undef KERNEL_VISIT
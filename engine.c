@@ -0,0 +1,764 @@
+#include "engine.h"
+
+#include <pthread.h>
+
+#include "dijkstra.h"
+#include "search.h"
+#include "hublabel.h"
+#include "memstat.h"
+/*
+ * Routing engines
+ *
+ * Registry of interchangeable shortest-path implementations, the "auto"
+ * selection policy, and a self-check that cross-validates every engine
+ * against the reference array Dijkstra.
+ */
+
+// Graphs at or below this many vertices are served by the array Dijkstra:
+// its linear select-min is as fast as a heap when V is tiny.
+#define AUTO_SMALL_GRAPH_VERTICES 64
+
+// Auto mode builds hub labels only when at least this many queries per
+// vertex are expected (the build runs one pruned search per vertex) and the
+// graph is small enough for labels to stay compact.
+#define AUTO_HUB_LABEL_QUERIES_PER_VERTEX 1
+#define AUTO_HUB_LABEL_MAX_VERTICES 200000
+
+// Idle workspaces kept per heap engine; extras are freed on release, as are
+// idle workspaces while the MEM_CACHE budget is exceeded.
+#define WORKSPACE_POOL_LIMIT 64
+
+// Default cap on preprocessing index memory: 512 MiB.
+static size_t indexMemoryCap = (size_t)512 * 1024 * 1024;
+
+/*
+ * HubLabelState
+ * 	Prepared state of the hub-label engine.
+ */
+typedef struct {
+	HubLabelIndex *index;
+	HubLabelStats stats;
+} HubLabelState;
+
+/*
+ * WorkspacePool
+ * 	Prepared state of the heap engine: a mutex-protected free list of
+ * 	search workspaces so concurrent queries each get their own scratch
+ * 	memory without reallocating it on every query.
+ */
+typedef struct {
+	const Graph *graph;
+	pthread_mutex_t lock;
+	SearchWorkspace *idle[WORKSPACE_POOL_LIMIT];
+	int idleCount;
+} WorkspacePool;
+
+/*
+ * dijkstra_prepare
+ * 	The array Dijkstra needs no per-graph state; return the graph itself as
+ * 	a non-NULL token.
+ */
+static void *dijkstra_prepare(const Graph *graph) {
+	return (void *)graph;
+}
+
+/*
+ * dijkstra_query
+ * 	Forward to dijkstra_shortest_path.
+ */
+static int dijkstra_query(void *state, const Graph *graph, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance) {
+	(void)state;
+	return dijkstra_shortest_path(graph, src, dst, outPath, outPathLen, outTotalDistance);
+}
+
+/*
+ * dijkstra_distance_query
+ * 	Forward to dijkstra_distance.
+ */
+static int dijkstra_distance_query(void *state, const Graph *graph, int src, int dst, int *outTotalDistance) {
+	(void)state;
+	return dijkstra_distance(graph, src, dst, outTotalDistance);
+}
+
+/*
+ * dijkstra_free_state
+ * 	Nothing to release; see dijkstra_prepare.
+ */
+static void dijkstra_free_state(void *state) {
+	(void)state;
+}
+
+/*
+ * heap_prepare
+ * 	Create an empty workspace pool for 'graph'.
+ */
+static void *heap_prepare(const Graph *graph) {
+	if (graph == NULL) {
+		return NULL;
+	}
+	WorkspacePool *pool = (WorkspacePool *)mem_calloc(MEM_CACHE, 1, sizeof(WorkspacePool));
+	if (pool == NULL) {
+		return NULL;
+	}
+	pool->graph = graph;
+	if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+		mem_free(MEM_CACHE, pool, sizeof(WorkspacePool));
+		return NULL;
+	}
+	return pool;
+}
+
+/*
+ * pool_acquire
+ * 	Borrow a workspace from the pool, creating one if none is idle.
+ *
+ * Returns:
+ * 	The workspace, or NULL on a foreign graph or allocation failure.
+ */
+static SearchWorkspace *pool_acquire(WorkspacePool *pool, const Graph *graph) {
+	if (pool == NULL || graph != pool->graph) {
+		return NULL;
+	}
+	SearchWorkspace *ws = NULL;
+	pthread_mutex_lock(&pool->lock);
+	if (pool->idleCount > 0) {
+		ws = pool->idle[--pool->idleCount];
+	}
+	pthread_mutex_unlock(&pool->lock);
+	if (ws == NULL) {
+		ws = search_workspace_create(graph, MEM_CACHE);
+	}
+	return ws;
+}
+
+/*
+ * pool_release
+ * 	Return a workspace to the pool. Over the MEM_CACHE budget the pool
+ * 	shrinks instead: the workspace and any idle ones are freed until the
+ * 	cache fits again.
+ */
+static void pool_release(WorkspacePool *pool, SearchWorkspace *ws) {
+	pthread_mutex_lock(&pool->lock);
+	if (!mem_within_budget(MEM_CACHE, 0)) {
+		search_workspace_free(ws);
+		ws = NULL;
+		while (pool->idleCount > 0 && !mem_within_budget(MEM_CACHE, 0)) {
+			search_workspace_free(pool->idle[--pool->idleCount]);
+		}
+	} else if (pool->idleCount < WORKSPACE_POOL_LIMIT) {
+		pool->idle[pool->idleCount++] = ws;
+		ws = NULL;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	search_workspace_free(ws);
+}
+
+/*
+ * heap_query
+ * 	Run a heap-based shortest-path search in a pooled workspace.
+ */
+static int heap_query(void *state, const Graph *graph, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance) {
+	WorkspacePool *pool = (WorkspacePool *)state;
+	SearchWorkspace *ws = pool_acquire(pool, graph);
+	if (ws == NULL) {
+		return -1;
+	}
+	int found = search_shortest_path(ws, src, dst, outPath, outPathLen, outTotalDistance);
+	pool_release(pool, ws);
+	return found;
+}
+
+/*
+ * heap_distance
+ * 	Run a heap-based distance-only search in a pooled workspace.
+ */
+static int heap_distance(void *state, const Graph *graph, int src, int dst, int *outTotalDistance) {
+	WorkspacePool *pool = (WorkspacePool *)state;
+	SearchWorkspace *ws = pool_acquire(pool, graph);
+	if (ws == NULL) {
+		return -1;
+	}
+	int found = search_distance(ws, src, dst, outTotalDistance);
+	pool_release(pool, ws);
+	return found;
+}
+
+/*
+ * heap_free_state
+ * 	Release the pool and every idle workspace. Safe to call with NULL.
+ */
+static void heap_free_state(void *state) {
+	WorkspacePool *pool = (WorkspacePool *)state;
+	if (pool == NULL) {
+		return;
+	}
+	for (int i = 0; i < pool->idleCount; i++) {
+		search_workspace_free(pool->idle[i]);
+	}
+	pthread_mutex_destroy(&pool->lock);
+	mem_free(MEM_CACHE, pool, sizeof(WorkspacePool));
+}
+
+/*
+ * index_cap
+ * 	Bytes a new index may use: the engine cap, further limited by what is
+ * 	left of the MEM_INDEX budget (0 = unlimited).
+ */
+static size_t index_cap(void) {
+	size_t cap = indexMemoryCap;
+	size_t budget = mem_budget(MEM_INDEX);
+	if (budget > 0) {
+		size_t used = mem_current(MEM_INDEX);
+		// A budget that is already used up still caps at one byte, not "unlimited"
+		size_t left = used < budget ? budget - used : 1;
+		if (cap == 0 || left < cap) {
+			cap = left;
+		}
+	}
+	return cap;
+}
+
+/*
+ * hub_label_prepare
+ * 	Build the hub-label index, reporting a clean failure on stderr when it
+ * 	would exceed the index memory cap or budget.
+ */
+static void *hub_label_prepare(const Graph *graph) {
+	HubLabelState *state = (HubLabelState *)mem_calloc(MEM_INDEX, 1, sizeof(HubLabelState));
+	if (state == NULL) {
+		return NULL;
+	}
+	size_t cap = index_cap();
+	int status = hub_label_build(graph, cap, &state->index, &state->stats);
+	if (status != 1) {
+		if (status == 0) {
+			fprintf(stderr, "Hub label build exceeds the index memory cap of %zu bytes\n", cap);
+		}
+		mem_free(MEM_INDEX, state, sizeof(HubLabelState));
+		return NULL;
+	}
+	return state;
+}
+
+/*
+ * hub_label_query
+ * 	Answer from the labels alone; the graph is not touched.
+ */
+static int hub_label_query(void *state, const Graph *graph, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance) {
+	(void)graph;
+	HubLabelState *labels = (HubLabelState *)state;
+	if (labels == NULL) {
+		return -1;
+	}
+	return hub_label_path(labels->index, src, dst, outPath, outPathLen, outTotalDistance);
+}
+
+/*
+ * hub_label_distance_query
+ * 	Distance from a single merge of the two labels; no path is rebuilt.
+ */
+static int hub_label_distance_query(void *state, const Graph *graph, int src, int dst, int *outTotalDistance) {
+	(void)graph;
+	HubLabelState *labels = (HubLabelState *)state;
+	if (labels == NULL) {
+		return -1;
+	}
+	return hub_label_distance(labels->index, src, dst, outTotalDistance);
+}
+
+/*
+ * hub_label_free_state
+ * 	Release the index. Safe to call with NULL.
+ */
+static void hub_label_free_state(void *state) {
+	HubLabelState *labels = (HubLabelState *)state;
+	if (labels == NULL) {
+		return;
+	}
+	hub_label_free(labels->index);
+	mem_free(MEM_INDEX, labels, sizeof(HubLabelState));
+}
+
+/*
+ * hub_label_report
+ * 	Print label size, build time and peak build memory.
+ */
+static void hub_label_report(void *state, FILE *out) {
+	HubLabelState *labels = (HubLabelState *)state;
+	if (labels == NULL || out == NULL) {
+		return;
+	}
+	fprintf(out, "Hub labels: %lld entries (avg %.1f, max %d per city), %zu bytes, built in %.1f ms (peak %zu bytes)\n",
+		labels->stats.numEntries, labels->stats.averageLabelSize, labels->stats.maxLabelSize,
+		labels->stats.bytes, labels->stats.buildMs, labels->stats.peakBuildBytes);
+}
+
+static const RoutingEngine ENGINES[] = {
+	{
+		"dijkstra",
+		"array Dijkstra, O(V^2 + E) per query, no preprocessing",
+		ENGINE_CAP_PATH | ENGINE_CAP_THREAD_SAFE | ENGINE_CAP_REFERENCE,
+		dijkstra_prepare,
+		dijkstra_query,
+		dijkstra_distance_query,
+		dijkstra_free_state,
+		NULL
+	},
+	{
+		"heap",
+		"binary-heap Dijkstra with pooled workspaces, O((V + E) log V) per query",
+		ENGINE_CAP_PATH | ENGINE_CAP_THREAD_SAFE,
+		heap_prepare,
+		heap_query,
+		heap_distance,
+		heap_free_state,
+		NULL
+	},
+	{
+		"hub-label",
+		"pruned landmark labeling, label merge per query after preprocessing",
+		ENGINE_CAP_PATH | ENGINE_CAP_PREPROCESS | ENGINE_CAP_THREAD_SAFE,
+		hub_label_prepare,
+		hub_label_query,
+		hub_label_distance_query,
+		hub_label_free_state,
+		hub_label_report
+	}
+};
+
+#define ENGINE_COUNT ((int)(sizeof(ENGINES) / sizeof(ENGINES[0])))
+
+/*
+ * engine_count
+ * 	Number of registered engines.
+ */
+int engine_count(void) {
+	return ENGINE_COUNT;
+}
+
+/*
+ * engine_at
+ * 	Engine by registry index, or NULL when out of range.
+ */
+const RoutingEngine *engine_at(int index) {
+	if (index < 0 || index >= ENGINE_COUNT) {
+		return NULL;
+	}
+	return &ENGINES[index];
+}
+
+/*
+ * engine_find
+ * 	Look up an engine by exact name.
+ */
+const RoutingEngine *engine_find(const char *name) {
+	if (name == NULL) {
+		return NULL;
+	}
+	for (int i = 0; i < ENGINE_COUNT; i++) {
+		if (strcmp(ENGINES[i].name, name) == 0) {
+			return &ENGINES[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * engine_distance
+ * 	Prefer the engine's distance-only search; engines without one answer
+ * 	through query and the path is dropped.
+ */
+int engine_distance(const RoutingEngine *engine, void *state, const Graph *graph, int src, int dst, int *outTotalDistance) {
+	if (engine == NULL || outTotalDistance == NULL) {
+		return -1;
+	}
+	if (engine->distance != NULL) {
+		return engine->distance(state, graph, src, dst, outTotalDistance);
+	}
+	int *path = NULL;
+	int pathLen = 0;
+	int found = engine->query(state, graph, src, dst, &path, &pathLen, outTotalDistance);
+	if (found > 0) {
+		free(path);
+	}
+	return found;
+}
+
+/*
+ * engine_set_index_memory_cap
+ * 	Set the byte cap applied by preprocessing engines.
+ */
+void engine_set_index_memory_cap(size_t bytes) {
+	indexMemoryCap = bytes;
+}
+
+/*
+ * engine_auto_select
+ * 	Small graphs always use the array Dijkstra: a query is a handful of
+ * 	scans and a label index would not pay for itself. Otherwise, when
+ * 	enough queries are expected to amortize one pruned search per vertex,
+ * 	build hub labels. Dense graphs (E >= V^2 / 4) favour the array
+ * 	Dijkstra, whose O(V^2) scan beats O(E log V) there, and everything
+ * 	else uses the heap.
+ */
+const RoutingEngine *engine_auto_select(const Graph *graph, long expectedQueries) {
+	if (graph == NULL) {
+		return engine_find("dijkstra");
+	}
+	long long v = graph->numVertices;
+	long long e = graph->numEdges;
+	if (v <= AUTO_SMALL_GRAPH_VERTICES) {
+		return engine_find("dijkstra");
+	}
+	if (v <= AUTO_HUB_LABEL_MAX_VERTICES && expectedQueries >= v * AUTO_HUB_LABEL_QUERIES_PER_VERTEX) {
+		return engine_find("hub-label");
+	}
+	if (e * 4 >= v * v) {
+		return engine_find("dijkstra");
+	}
+	return engine_find("heap");
+}
+
+/*
+ * engine_resolve
+ * 	"auto" defers to engine_auto_select; any other name must be registered.
+ */
+const RoutingEngine *engine_resolve(const char *name, const Graph *graph, long expectedQueries) {
+	if (name != NULL && strcmp(name, "auto") == 0) {
+		return engine_auto_select(graph, expectedQueries);
+	}
+	return engine_find(name);
+}
+
+/*
+ * next_random
+ * 	xorshift32 step; deterministic for a given seed so failures reproduce.
+ */
+static unsigned int next_random(unsigned int *state) {
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/*
+ * edge_weight
+ * 	Smallest weight of an edge u -> v, or -1 if there is none.
+ */
+static int edge_weight(const Graph *graph, int u, int v) {
+	int best = -1;
+	for (Edge *e = graph->adjacency[u]; e != NULL; e = e->next) {
+		if (e->to == v && (best < 0 || e->weight < best)) {
+			best = e->weight;
+		}
+	}
+	return best;
+}
+
+/*
+ * path_is_valid
+ * 	Check that 'path' runs from src to dst over existing edges and that its
+ * 	weights add up to 'total'.
+ */
+static int path_is_valid(const Graph *graph, const int *path, int pathLen, int src, int dst, long long total) {
+	if (path == NULL || pathLen <= 0 || path[0] != src || path[pathLen - 1] != dst) {
+		return 0;
+	}
+	long long sum = 0;
+	for (int i = 1; i < pathLen; i++) {
+		int w = edge_weight(graph, path[i - 1], path[i]);
+		if (w < 0) {
+			return 0;
+		}
+		sum += w;
+	}
+	return sum == total;
+}
+
+/*
+ * reference_distances
+ * 	The self-check's oracle: the baseline array Dijkstra, written out here
+ * 	rather than generated from dijkstra_kernel.h so a kernel bug cannot
+ * 	hide in both the answers and the expectations. Runs in 64 bits without
+ * 	early exit and fills distance[] for every vertex (-1 if unreachable);
+ * 	'visited' is scratch of numVertices bytes.
+ */
+static void reference_distances(const Graph *graph, int src, long long *distance, unsigned char *visited) {
+	int n = graph->numVertices;
+	for (int i = 0; i < n; i++) {
+		distance[i] = -1;
+		visited[i] = 0;
+	}
+	distance[src] = 0;
+	for (int iter = 0; iter < n; iter++) {
+		int u = -1;
+		for (int i = 0; i < n; i++) {
+			if (!visited[i] && distance[i] >= 0 && (u == -1 || distance[i] < distance[u])) {
+				u = i;
+			}
+		}
+		if (u == -1) {
+			break; // remaining vertices unreachable
+		}
+		visited[u] = 1;
+		for (Edge *e = graph->adjacency[u]; e != NULL; e = e->next) {
+			int v = e->to;
+			long long candidate = distance[u] + e->weight;
+			if (!visited[v] && (distance[v] < 0 || candidate < distance[v])) {
+				distance[v] = candidate;
+			}
+		}
+	}
+}
+
+/*
+ * range_matches_reference
+ * 	Check one range answer against the oracle: every city other than the
+ * 	origin within 'budget', each once and at its reference distance,
+ * 	nearest first. Overwrites 'reference'.
+ */
+static int range_matches_reference(const Graph *graph, int origin, int budget, const RangeResult *results, int count, long long *reference, unsigned char *visited) {
+	reference_distances(graph, origin, reference, visited);
+	int expectedCount = 0;
+	for (int v = 0; v < graph->numVertices; v++) {
+		if (v != origin && reference[v] >= 0 && reference[v] <= budget) {
+			expectedCount++;
+		}
+	}
+	if (count != expectedCount) {
+		return 0;
+	}
+	reference[origin] = -1;
+	for (int i = 0; i < count; i++) {
+		int v = results[i].vertex;
+		if (v < 0 || v >= graph->numVertices || reference[v] != results[i].distance
+			|| (i > 0 && results[i].distance < results[i - 1].distance)) {
+			return 0;
+		}
+		reference[v] = -1; // a repeated city no longer matches
+	}
+	return 1;
+}
+
+/*
+ * check_range_batch
+ * 	Answer 'queries' random range queries with one search_within_batch
+ * 	call, compare each query's slice with a separate search_within, and
+ * 	check the single answer against the oracle. Budgets go up to four
+ * 	times the heaviest edge so results span a few hops.
+ *
+ * Returns:
+ * 	Number of mismatching queries, or -1 on allocation failure.
+ */
+static int check_range_batch(const Graph *graph, int queries, unsigned int *rng, long long *reference, unsigned char *visited, FILE *report) {
+	long long maxWeight = 1;
+	for (int v = 0; v < graph->numVertices; v++) {
+		for (Edge *e = graph->adjacency[v]; e != NULL; e = e->next) {
+			if (e->weight > maxWeight) {
+				maxWeight = e->weight;
+			}
+		}
+	}
+	long long budgetLimit = maxWeight * 4 < INF_DISTANCE ? maxWeight * 4 : INF_DISTANCE - 1;
+	SearchWorkspace *ws = search_workspace_create(graph, MEM_SCRATCH);
+	int *origins = (int *)malloc((size_t)queries * sizeof(int));
+	int *budgets = (int *)malloc((size_t)queries * sizeof(int));
+	RangeResult *batched = NULL;
+	int *offsets = NULL;
+	int mismatches = -1;
+	if (ws != NULL && origins != NULL && budgets != NULL) {
+		for (int q = 0; q < queries; q++) {
+			origins[q] = (int)(next_random(rng) % (unsigned int)graph->numVertices);
+			budgets[q] = (int)(next_random(rng) % (unsigned int)(budgetLimit + 1));
+		}
+		if (search_within_batch(ws, origins, budgets, queries, &batched, &offsets) > 0) {
+			mismatches = 0;
+		}
+	}
+	for (int q = 0; mismatches >= 0 && q < queries; q++) {
+		RangeResult *single = NULL;
+		int count = 0;
+		if (search_within(ws, origins[q], budgets[q], &single, &count) < 0) {
+			mismatches = -1;
+			break;
+		}
+		int batchedCount = offsets[q + 1] - offsets[q];
+		int agrees = count == batchedCount
+			&& (count == 0 || memcmp(single, batched + offsets[q], (size_t)count * sizeof(RangeResult)) == 0)
+			&& range_matches_reference(graph, origins[q], budgets[q], single, count, reference, visited);
+		if (!agrees) {
+			if (mismatches == 0) {
+				fprintf(report, "range search: mismatch within %s %d (batched %d cities, single %d)\n",
+					graph->vertexNames[origins[q]], budgets[q], batchedCount, count);
+			}
+			mismatches++;
+		}
+		free(single);
+	}
+	if (mismatches >= 0) {
+		fprintf(report, "range search: %d batched queries, %d mismatches\n", queries, mismatches);
+	}
+	free(batched);
+	free(offsets);
+	free(origins);
+	free(budgets);
+	search_workspace_free(ws);
+	return mismatches;
+}
+
+/*
+ * check_wide_searches
+ * 	The 64-bit searches are kernel instances as well; check their distance
+ * 	and path answers against the oracle's.
+ *
+ * Returns:
+ * 	Number of mismatching queries.
+ */
+static int check_wide_searches(const Graph *graph, const int *sources, const int *targets, const long long *expected, int queries, FILE *report) {
+	int mismatches = 0;
+	for (int q = 0; q < queries; q++) {
+		int src = sources[q];
+		int dst = targets[q];
+		long long total = 0;
+		int found = dijkstra_distance_wide(graph, src, dst, &total);
+		int *path = NULL;
+		int pathLen = 0;
+		long long pathTotal = 0;
+		int pathFound = dijkstra_shortest_path_wide(graph, src, dst, &path, &pathLen, &pathTotal);
+		int agrees;
+		if (expected[q] < 0) {
+			agrees = found == 0 && pathFound == 0;
+		} else {
+			agrees = found > 0 && total == expected[q] && pathFound > 0 && pathTotal == expected[q]
+				&& path_is_valid(graph, path, pathLen, src, dst, pathTotal);
+		}
+		if (!agrees) {
+			if (mismatches == 0) {
+				fprintf(report, "wide search: mismatch %s -> %s (got %d/%lld and %d/%lld, expected %lld)\n",
+					graph->vertexNames[src], graph->vertexNames[dst], found, total, pathFound, pathTotal, expected[q]);
+			}
+			mismatches++;
+		}
+		if (pathFound > 0) {
+			free(path);
+		}
+	}
+	fprintf(report, "wide search: %d queries, %d mismatches\n", queries, mismatches);
+	return mismatches;
+}
+
+/*
+ * answer_agrees
+ * 	Whether an int search's status and total match the oracle's distance
+ * 	(-1 when unreachable). Pairs that are INF_DISTANCE or more apart must
+ * 	be reported as DIJKSTRA_TOO_LONG; for unreachable pairs either 0 or
+ * 	DIJKSTRA_TOO_LONG is correct, since an int search cannot tell a
+ * 	missing route from one it skipped.
+ */
+static int answer_agrees(int found, int total, long long expected) {
+	if (expected < 0) {
+		return found == 0 || found == DIJKSTRA_TOO_LONG;
+	}
+	if (expected >= INF_DISTANCE) {
+		return found == DIJKSTRA_TOO_LONG;
+	}
+	return found > 0 && total == expected;
+}
+
+/*
+ * engine_self_check
+ * 	Compute the expected distance of each random query once with the
+ * 	independent oracle (reference_distances), then check the 64-bit
+ * 	searches and every engine (the reference included) on the same
+ * 	queries, through both its path query and its distance lookup (see
+ * 	answer_agrees). Finally check range queries, batched and single,
+ * 	against the oracle too.
+ */
+int engine_self_check(const Graph *graph, int queries, unsigned int seed, FILE *report) {
+	if (graph == NULL || queries <= 0 || report == NULL) {
+		return -1;
+	}
+	int n = graph->numVertices;
+	int *sources = (int *)malloc((size_t)queries * sizeof(int));
+	int *targets = (int *)malloc((size_t)queries * sizeof(int));
+	long long *expected = (long long *)malloc((size_t)queries * sizeof(long long));
+	long long *reference = (long long *)malloc((size_t)n * sizeof(long long));
+	unsigned char *visited = (unsigned char *)malloc((size_t)n);
+	if (sources == NULL || targets == NULL || expected == NULL || reference == NULL || visited == NULL) {
+		free(sources);
+		free(targets);
+		free(expected);
+		free(reference);
+		free(visited);
+		return -1;
+	}
+	unsigned int rng = seed != 0 ? seed : 1;
+	int beyondInt = 0;
+	for (int q = 0; q < queries; q++) {
+		sources[q] = (int)(next_random(&rng) % (unsigned int)n);
+		targets[q] = (int)(next_random(&rng) % (unsigned int)n);
+		reference_distances(graph, sources[q], reference, visited);
+		expected[q] = reference[targets[q]]; // -1 when unreachable
+		if (expected[q] >= INF_DISTANCE) {
+			beyondInt++;
+		}
+	}
+	if (beyondInt > 0) {
+		fprintf(report, "%d of %d pairs are %d or more apart and must be reported as too long\n",
+			beyondInt, queries, INF_DISTANCE);
+	}
+
+	int totalMismatches = check_wide_searches(graph, sources, targets, expected, queries, report);
+	for (int k = 0; k < ENGINE_COUNT; k++) {
+		const RoutingEngine *engine = &ENGINES[k];
+		void *state = engine->prepare(graph);
+		if (state == NULL) {
+			fprintf(report, "engine %s: prepare failed\n", engine->name);
+			totalMismatches++;
+			continue;
+		}
+		int mismatches = 0;
+		for (int q = 0; q < queries; q++) {
+			int src = sources[q];
+			int dst = targets[q];
+			int *path = NULL;
+			int pathLen = 0;
+			int total = 0;
+			int found = engine->query(state, graph, src, dst, &path, &pathLen, &total);
+			int distanceTotal = 0;
+			int distanceFound = engine_distance(engine, state, graph, src, dst, &distanceTotal);
+
+			int agrees = answer_agrees(found, total, expected[q]);
+			if (agrees && found > 0 && (engine->capabilities & ENGINE_CAP_PATH)) {
+				agrees = path_is_valid(graph, path, pathLen, src, dst, total);
+			}
+			agrees = agrees && answer_agrees(distanceFound, distanceTotal, expected[q]);
+			if (!agrees) {
+				if (mismatches == 0) {
+					fprintf(report, "engine %s: mismatch %s -> %s (got %d/%d, distance %d/%d, expected %lld)\n",
+						engine->name, graph->vertexNames[src], graph->vertexNames[dst],
+						found, total, distanceFound, distanceTotal, expected[q]);
+				}
+				mismatches++;
+			}
+			if (found > 0) {
+				free(path);
+			}
+		}
+		fprintf(report, "engine %s: %d queries, %d mismatches\n", engine->name, queries, mismatches);
+		totalMismatches += mismatches;
+		engine->free_state(state);
+	}
+	int rangeMismatches = check_range_batch(graph, queries, &rng, reference, visited, report);
+	free(sources);
+	free(targets);
+	free(expected);
+	free(reference);
+	free(visited);
+	if (rangeMismatches < 0) {
+		return -1;
+	}
+	return totalMismatches + rangeMismatches;
+}
@@ -0,0 +1,76 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdio.h>
+
+#include "graph.h"
+
+// Capability flags advertised by each routing engine.
+#define ENGINE_CAP_PATH         0x1u  // query returns the full path, not just the distance
+#define ENGINE_CAP_PREPROCESS   0x2u  // prepare does real work that pays off over many queries
+#define ENGINE_CAP_THREAD_SAFE  0x4u  // query may run concurrently on one prepared state
+#define ENGINE_CAP_REFERENCE    0x8u  // baseline implementation other engines are measured against
+
+// A shortest-path algorithm behind a common interface.
+//   prepare    - builds per-graph state; returns NULL on failure
+//   query      - same contract as dijkstra_shortest_path
+//   distance   - optional (may be NULL); same contract as dijkstra_distance,
+//                answered without building the path
+//   free_state - releases what prepare returned (safe with NULL)
+//   report     - optional (may be NULL); prints preprocessing figures
+// The graph must outlive the prepared state.
+typedef struct {
+	const char *name;
+	const char *description;
+	unsigned int capabilities;
+	void *(*prepare)(const Graph *graph);
+	int (*query)(void *state, const Graph *graph, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance);
+	int (*distance)(void *state, const Graph *graph, int src, int dst, int *outTotalDistance);
+	void (*free_state)(void *state);
+	void (*report)(void *state, FILE *out);
+} RoutingEngine;
+
+// Number of registered engines and access by index (0 is the reference).
+int engine_count(void);
+const RoutingEngine *engine_at(int index);
+
+// Returns the engine with the given name, or NULL if none matches.
+const RoutingEngine *engine_find(const char *name);
+
+// engine_distance:
+//   Shortest distance from src to dst through 'engine' and its prepared
+//   state: its distance entry when it has one, otherwise query with the
+//   path discarded. Same return codes as dijkstra_distance.
+int engine_distance(const RoutingEngine *engine, void *state, const Graph *graph, int src, int dst, int *outTotalDistance);
+
+// Caps the memory preprocessing engines may use for their index, in bytes
+// (0 = unlimited). Engines whose index would exceed it fail to prepare.
+void engine_set_index_memory_cap(size_t bytes);
+
+// engine_auto_select:
+//   Picks an engine from the graph's size and density and the number of
+//   queries expected over the graph's lifetime.
+const RoutingEngine *engine_auto_select(const Graph *graph, long expectedQueries);
+
+// engine_resolve:
+//   Maps a user-facing engine name ("auto" or a registered name) to an
+//   engine for 'graph'. Returns NULL for unknown names.
+const RoutingEngine *engine_resolve(const char *name, const Graph *graph, long expectedQueries);
+
+// engine_self_check:
+//   Runs 'queries' random source/destination pairs through the 64-bit
+//   searches and every engine, including the reference, through both
+//   query and engine_distance, and compares reachability and distance with
+//   a hand-written 64-bit array Dijkstra that does not share the search
+//   kernel. Paths from engines with
+//   ENGINE_CAP_PATH are also validated edge by edge. Then answers 'queries'
+//   random range queries with search_within_batch and checks them against
+//   single search_within calls and the same oracle. Writes one summary line
+//   for the 64-bit searches, one per engine and one for the range queries
+//   to 'report'.
+// Returns:
+//   number of mismatches found (0 means all engines agree), or -1 on
+//   invalid input or allocation failure.
+int engine_self_check(const Graph *graph, int queries, unsigned int seed, FILE *report);
+
+#endif
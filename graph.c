@@ -1,4 +1,6 @@
 #include "graph.h"
+#include "io.h"
+#include "memstat.h"
 /*
  * Graph module
  *
@@ -7,32 +9,10 @@
  *  - allocate/free graphs
  *  - set and look up vertex names
  *  - add undirected edges
+ *  - compact duplicate and parallel edges
  *  - list city names
  */
 
-/* 
- * duplicate_string
- * 	Create a heap-allocated copy of a C string.
- *
- * Parameters:
- * 	- source: input string (may be NULL)
- *
- * Returns:
- * 	Newly allocated null-terminated copy or NULL on error/NULL input.
- */
-static char *duplicate_string(const char *source) {
-	if (source == NULL) {
-		return NULL;
-	}
-	size_t len = strlen(source);
-	char *copy = (char *)malloc(len + 1);
-	if (copy == NULL) {
-		return NULL;
-	}
-	memcpy(copy, source, len + 1);
-	return copy;
-}
-
 /* 
  * create_graph
  * 	Allocate a graph with space for 'numVertices' vertices. Vertex names
@@ -45,17 +25,18 @@ Graph *create_graph(int numVertices) {
 	if (numVertices <= 0) {
 		return NULL;
 	}
-	Graph *graph = (Graph *)malloc(sizeof(Graph));
+	Graph *graph = (Graph *)mem_malloc(MEM_ADJACENCY, sizeof(Graph));
 	if (graph == NULL) {
 		return NULL;
 	}
 	graph->numVertices = numVertices;
-	graph->vertexNames = (char **)calloc((size_t)numVertices, sizeof(char *));
-	graph->adjacency = (Edge **)calloc((size_t)numVertices, sizeof(Edge *));
+	graph->numEdges = 0;
+	graph->vertexNames = (char **)mem_calloc(MEM_NAMES, (size_t)numVertices, sizeof(char *));
+	graph->adjacency = (Edge **)mem_calloc(MEM_ADJACENCY, (size_t)numVertices, sizeof(Edge *));
 	if (graph->vertexNames == NULL || graph->adjacency == NULL) {
-		free(graph->vertexNames);
-		free(graph->adjacency);
-		free(graph);
+		mem_free(MEM_NAMES, graph->vertexNames, (size_t)numVertices * sizeof(char *));
+		mem_free(MEM_ADJACENCY, graph->adjacency, (size_t)numVertices * sizeof(Edge *));
+		mem_free(MEM_ADJACENCY, graph, sizeof(Graph));
 		return NULL;
 	}
 	return graph;
@@ -73,18 +54,18 @@ void free_graph(Graph *graph) {
 	}
 	for (int i = 0; i < graph->numVertices; i++) {
 		if (graph->vertexNames != NULL && graph->vertexNames[i] != NULL) {
-			free(graph->vertexNames[i]);
+			mem_strfree(MEM_NAMES, graph->vertexNames[i]);
 		}
 		Edge *edge = graph->adjacency != NULL ? graph->adjacency[i] : NULL;
 		while (edge != NULL) {
 			Edge *next = edge->next;
-			free(edge);
+			mem_free(MEM_ADJACENCY, edge, sizeof(Edge));
 			edge = next;
 		}
 	}
-	free(graph->vertexNames);
-	free(graph->adjacency);
-	free(graph);
+	mem_free(MEM_NAMES, graph->vertexNames, (size_t)graph->numVertices * sizeof(char *));
+	mem_free(MEM_ADJACENCY, graph->adjacency, (size_t)graph->numVertices * sizeof(Edge *));
+	mem_free(MEM_ADJACENCY, graph, sizeof(Graph));
 }
 
 /* 
@@ -98,10 +79,10 @@ void set_vertex_name(Graph *graph, int index, const char *name) {
 		return;
 	}
 	if (graph->vertexNames[index] != NULL) {
-		free(graph->vertexNames[index]);
+		mem_strfree(MEM_NAMES, graph->vertexNames[index]);
 		graph->vertexNames[index] = NULL;
 	}
-	graph->vertexNames[index] = duplicate_string(name);
+	graph->vertexNames[index] = mem_strdup(MEM_NAMES, name);
 }
 
 /* 
@@ -133,7 +114,7 @@ void add_undirected_edge(Graph *graph, int u, int v, int weight) {
 	if (u < 0 || u >= graph->numVertices || v < 0 || v >= graph->numVertices) {
 		return;
 	}
-	Edge *e1 = (Edge *)malloc(sizeof(Edge));
+	Edge *e1 = (Edge *)mem_malloc(MEM_ADJACENCY, sizeof(Edge));
 	if (e1 == NULL) {
 		return;
 	}
@@ -141,8 +122,9 @@ void add_undirected_edge(Graph *graph, int u, int v, int weight) {
 	e1->weight = weight;
 	e1->next = graph->adjacency[u];
 	graph->adjacency[u] = e1;
+	graph->numEdges++;
 
-	Edge *e2 = (Edge *)malloc(sizeof(Edge));
+	Edge *e2 = (Edge *)mem_malloc(MEM_ADJACENCY, sizeof(Edge));
 	if (e2 == NULL) {
 		return;
 	}
@@ -150,21 +132,127 @@ void add_undirected_edge(Graph *graph, int u, int v, int weight) {
 	e2->weight = weight;
 	e2->next = graph->adjacency[v];
 	graph->adjacency[v] = e2;
+	graph->numEdges++;
+}
+
+/* 
+ * edge_before
+ * 	Order for compaction: by neighbor, then by weight so the shortest edge
+ * 	to each neighbor comes first.
+ */
+static int edge_before(const Edge *a, const Edge *b) {
+	return a->to < b->to || (a->to == b->to && a->weight <= b->weight);
+}
+
+/* 
+ * sort_edges
+ * 	Merge sort of a singly linked adjacency list; stable and needs no
+ * 	extra memory.
+ *
+ * Returns:
+ * 	New head of the sorted list.
+ */
+static Edge *sort_edges(Edge *head) {
+	if (head == NULL || head->next == NULL) {
+		return head;
+	}
+	// Split after the middle node using slow/fast pointers
+	Edge *slow = head;
+	Edge *fast = head->next;
+	while (fast != NULL && fast->next != NULL) {
+		slow = slow->next;
+		fast = fast->next->next;
+	}
+	Edge *second = slow->next;
+	slow->next = NULL;
+	Edge *a = sort_edges(head);
+	Edge *b = sort_edges(second);
+
+	Edge merged;
+	Edge *tail = &merged;
+	while (a != NULL && b != NULL) {
+		if (edge_before(a, b)) {
+			tail->next = a;
+			a = a->next;
+		} else {
+			tail->next = b;
+			b = b->next;
+		}
+		tail = tail->next;
+	}
+	tail->next = a != NULL ? a : b;
+	return merged.next;
+}
+
+/* 
+ * compact_edges
+ * 	Sort each adjacency list, then keep the first (shortest) edge to each
+ * 	neighbor and free the rest along with any self-loops. Both directions
+ * 	of an undirected edge are stored, so every removal is seen twice and the
+ * 	directed counts are halved for the report.
+ */
+void compact_edges(Graph *graph, EdgeCompaction *outStats) {
+	if (outStats != NULL) {
+		memset(outStats, 0, sizeof(*outStats));
+	}
+	if (graph == NULL) {
+		return;
+	}
+	long long duplicates = 0;
+	long long parallel = 0;
+	long long selfLoops = 0;
+	for (int u = 0; u < graph->numVertices; u++) {
+		graph->adjacency[u] = sort_edges(graph->adjacency[u]);
+		Edge **link = &graph->adjacency[u];
+		const Edge *kept = NULL;
+		while (*link != NULL) {
+			Edge *edge = *link;
+			int drop = 1;
+			if (edge->to == u) {
+				selfLoops++;
+			} else if (kept != NULL && kept->to == edge->to) {
+				if (kept->weight == edge->weight) {
+					duplicates++;
+				} else {
+					parallel++;
+				}
+			} else {
+				drop = 0;
+			}
+			if (!drop) {
+				kept = edge;
+				link = &edge->next;
+				continue;
+			}
+			*link = edge->next;
+			mem_free(MEM_ADJACENCY, edge, sizeof(Edge));
+			graph->numEdges--;
+		}
+	}
+	if (outStats != NULL) {
+		outStats->duplicates = (int)(duplicates / 2);
+		outStats->parallel = (int)(parallel / 2);
+		outStats->selfLoops = (int)(selfLoops / 2);
+	}
 }
 
 /* 
  * list_cities
- * 	Print each non-NULL vertex name, one per line, to stdout.
+ * 	Print each non-NULL vertex name, one per line, to stdout through a
+ * 	LineWriter.
  */
 void list_cities(const Graph *graph) {
 	if (graph == NULL) {
 		return;
 	}
+	LineWriter writer;
+	line_writer_init(&writer, stdout);
 	for (int i = 0; i < graph->numVertices; i++) {
 		if (graph->vertexNames[i] != NULL) {
-			printf("%s\n", graph->vertexNames[i]);
+			line_writer_put(&writer, graph->vertexNames[i]);
 		}
 	}
+	line_writer_flush(&writer);
 }
 
 
@@ -13,6 +13,7 @@ typedef struct Edge {
 
 typedef struct {
 	int numVertices;
+	int numEdges;         // directed adjacency entries (2 per undirected edge)
 	char **vertexNames;   // size numVertices
 	Edge **adjacency;     // size numVertices, each a linked list
 } Graph;
@@ -31,6 +32,18 @@ int find_vertex_index(const Graph *graph, const char *name);
 // Adds an undirected weighted edge between u and v.
 void add_undirected_edge(Graph *graph, int u, int v, int weight);
 
+// Undirected edges removed by compact_edges, by reason.
+typedef struct {
+	int duplicates;   // same endpoints and weight as the edge that was kept
+	int parallel;     // same endpoints as a shorter edge that was kept
+	int selfLoops;    // both endpoints the same city
+} EdgeCompaction;
+
+// Normalizes the adjacency lists: sorts each by (neighbor, weight), keeps
+// only the shortest edge to each neighbor and drops self-loops, updating
+// numEdges. Shortest-path answers are unchanged. outStats may be NULL.
+void compact_edges(Graph *graph, EdgeCompaction *outStats);
+
 // Prints each city name on its own line in index order.
 void list_cities(const Graph *graph);
 
@@ -0,0 +1,302 @@
+#define _POSIX_C_SOURCE 200809L
+#include "graphstore.h"
+
+#include <time.h>
+
+#include "io.h"
+#include "memstat.h"
+/*
+ * Graph store
+ *
+ * Publishes the active graph to readers and replaces it on reload without
+ * stopping them. A reload builds the new graph on a background thread,
+ * atomically swaps the current version pointer, and then waits for an
+ * epoch grace period before freeing the old version.
+ */
+
+/*
+ * create_version
+ * 	Wrap 'graph' and its name index in a new GraphVersion and prepare the
+ * 	store's routing engine for it. The index is built here only when the
+ * 	loader did not provide one. Takes ownership of 'graph' and 'names' only
+ * 	on success.
+ */
+static GraphVersion *create_version(const GraphStore *store, Graph *graph, NameIndex *names, unsigned long generation) {
+	const RoutingEngine *engine = engine_resolve(store->engineName, graph, store->expectedQueries);
+	if (engine == NULL) {
+		return NULL;
+	}
+	GraphVersion *version = (GraphVersion *)malloc(sizeof(GraphVersion));
+	if (version == NULL) {
+		return NULL;
+	}
+	version->graph = graph;
+	version->generation = generation;
+	memset(&version->compaction, 0, sizeof(version->compaction));
+	version->names = names != NULL ? names : name_index_build(graph);
+	if (version->names == NULL) {
+		free(version);
+		return NULL;
+	}
+	version->engine = engine;
+	version->engineState = engine->prepare(graph);
+	if (version->engineState == NULL && strcmp(store->engineName, "auto") == 0) {
+		// Preprocessing failed (e.g. index memory cap); fall back to a query-time engine
+		version->engine = engine_auto_select(graph, 0);
+		version->engineState = version->engine->prepare(graph);
+	}
+	if (version->engineState == NULL) {
+		if (version->names != names) {
+			name_index_free(version->names);
+		}
+		free(version);
+		return NULL;
+	}
+	return version;
+}
+
+/*
+ * free_version
+ * 	Release a version and everything it owns. Safe to call with NULL.
+ */
+static void free_version(GraphVersion *version) {
+	if (version == NULL) {
+		return;
+	}
+	version->engine->free_state(version->engineState);
+	name_index_free(version->names);
+	free_graph(version->graph);
+	free(version);
+}
+
+/*
+ * synchronize_readers
+ * 	Advance the epoch and wait until no reader can still be inside a
+ * 	critical section that started before the advance.
+ */
+static void synchronize_readers(GraphStore *store) {
+	unsigned long target = atomic_fetch_add(&store->epoch, 1) + 1;
+	for (int i = 0; i < GRAPH_STORE_MAX_READERS; i++) {
+		while (1) {
+			unsigned long seen = atomic_load(&store->readerEpochs[i]);
+			if (seen == 0 || seen >= target) {
+				break;
+			}
+			struct timespec pause = { 0, 100000 }; // 100us
+			nanosleep(&pause, NULL);
+		}
+	}
+}
+
+/*
+ * reload_thread_main
+ * 	Background thread body: load the pending files, publish the new version
+ * 	and reclaim the old one after the grace period.
+ */
+static void *reload_thread_main(void *arg) {
+	GraphStore *store = (GraphStore *)arg;
+	Graph *graph = NULL;
+	NameIndex *names = NULL;
+	GraphVersion *fresh = NULL;
+	EdgeCompaction compaction;
+	if (load_graph(store->reloadVerticesPath, store->reloadDistancesPath, store->ingestThreads, &graph, &names, &compaction)) {
+		// Only the reload thread ever replaces 'current', so reading it here is stable
+		GraphVersion *active = atomic_load(&store->current);
+		fresh = create_version(store, graph, names, active->generation + 1);
+		if (fresh == NULL) {
+			name_index_free(names);
+			free_graph(graph);
+		} else {
+			fresh->compaction = compaction;
+		}
+	}
+	if (fresh == NULL) {
+		atomic_store(&store->reloadResult, RELOAD_FAILED);
+		atomic_store(&store->reloading, 0);
+		return NULL;
+	}
+	GraphVersion *old = atomic_exchange(&store->current, fresh);
+	synchronize_readers(store);
+	free_version(old);
+	atomic_store(&store->reloadResult, RELOAD_SUCCEEDED);
+	atomic_store(&store->reloading, 0);
+	return NULL;
+}
+
+/*
+ * graph_store_create
+ * 	Allocate a store whose first version (generation 1) wraps 'initial',
+ * 	with the routing engine chosen by 'engineName' prepared for it.
+ *
+ * Returns:
+ * 	Pointer to GraphStore on success; NULL on invalid input or allocation
+ * 	failure.
+ */
+GraphStore *graph_store_create(Graph *initial, NameIndex *initialNames, const char *engineName, long expectedQueries, int ingestThreads) {
+	if (initial == NULL || engineName == NULL) {
+		return NULL;
+	}
+	GraphStore *store = (GraphStore *)calloc(1, sizeof(GraphStore));
+	if (store == NULL) {
+		return NULL;
+	}
+	store->engineName = mem_strdup(MEM_SCRATCH, engineName);
+	store->expectedQueries = expectedQueries;
+	store->ingestThreads = ingestThreads;
+	GraphVersion *version = store->engineName != NULL ? create_version(store, initial, initialNames, 1) : NULL;
+	if (version == NULL) {
+		mem_strfree(MEM_SCRATCH, store->engineName);
+		free(store);
+		return NULL;
+	}
+	atomic_init(&store->current, version);
+	atomic_init(&store->epoch, 1);
+	for (int i = 0; i < GRAPH_STORE_MAX_READERS; i++) {
+		atomic_init(&store->readerEpochs[i], 0);
+		atomic_init(&store->readerInUse[i], 0);
+	}
+	atomic_init(&store->reloading, 0);
+	atomic_init(&store->reloadResult, RELOAD_NONE);
+	return store;
+}
+
+/*
+ * graph_store_free
+ * 	Wait for any reload to finish, then release the active version and the
+ * 	store. Safe to call with NULL.
+ */
+void graph_store_free(GraphStore *store) {
+	if (store == NULL) {
+		return;
+	}
+	graph_store_wait_reload(store);
+	free_version(atomic_load(&store->current));
+	mem_strfree(MEM_SCRATCH, store->reloadVerticesPath);
+	mem_strfree(MEM_SCRATCH, store->reloadDistancesPath);
+	mem_strfree(MEM_SCRATCH, store->engineName);
+	free(store);
+}
+
+/*
+ * graph_store_register_reader
+ * 	Claim a free reader slot.
+ *
+ * Returns:
+ * 	Slot index, or -1 if every slot is in use.
+ */
+int graph_store_register_reader(GraphStore *store) {
+	if (store == NULL) {
+		return -1;
+	}
+	for (int i = 0; i < GRAPH_STORE_MAX_READERS; i++) {
+		int expected = 0;
+		if (atomic_compare_exchange_strong(&store->readerInUse[i], &expected, 1)) {
+			atomic_store(&store->readerEpochs[i], 0);
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+ * graph_store_unregister_reader
+ * 	Release a slot obtained from graph_store_register_reader.
+ */
+void graph_store_unregister_reader(GraphStore *store, int slot) {
+	if (store == NULL || slot < 0 || slot >= GRAPH_STORE_MAX_READERS) {
+		return;
+	}
+	atomic_store(&store->readerEpochs[slot], 0);
+	atomic_store(&store->readerInUse[slot], 0);
+}
+
+/*
+ * graph_store_enter
+ * 	Announce the current epoch in 'slot', then load the active version.
+ * 	The announcement is ordered before the load, so a writer that swaps
+ * 	after we load will see our epoch and wait for graph_store_exit.
+ */
+const GraphVersion *graph_store_enter(GraphStore *store, int slot) {
+	atomic_store(&store->readerEpochs[slot], atomic_load(&store->epoch));
+	return atomic_load(&store->current);
+}
+
+/*
+ * graph_store_exit
+ * 	Mark 'slot' quiescent; the version returned by graph_store_enter must
+ * 	no longer be used.
+ */
+void graph_store_exit(GraphStore *store, int slot) {
+	atomic_store(&store->readerEpochs[slot], 0);
+}
+
+/*
+ * graph_store_generation
+ * 	Generation of the active version; the caller's read-side critical
+ * 	section keeps it from being freed while we read it.
+ */
+unsigned long graph_store_generation(GraphStore *store) {
+	return atomic_load(&store->current)->generation;
+}
+
+/*
+ * graph_store_reload_async
+ * 	Start a background reload from the given files.
+ *
+ * Returns:
+ * 	1 if the reload started; 0 if one is already running; -1 if the input
+ * 	is invalid, memory ran out or the thread could not be started.
+ */
+int graph_store_reload_async(GraphStore *store, const char *verticesFilePath, const char *distancesFilePath) {
+	if (store == NULL || verticesFilePath == NULL || distancesFilePath == NULL) {
+		return -1;
+	}
+	if (atomic_load(&store->reloading)) {
+		return 0;
+	}
+	graph_store_wait_reload(store);
+
+	char *vertices = mem_strdup(MEM_SCRATCH, verticesFilePath);
+	char *distances = mem_strdup(MEM_SCRATCH, distancesFilePath);
+	if (vertices == NULL || distances == NULL) {
+		mem_strfree(MEM_SCRATCH, vertices);
+		mem_strfree(MEM_SCRATCH, distances);
+		return -1;
+	}
+	mem_strfree(MEM_SCRATCH, store->reloadVerticesPath);
+	mem_strfree(MEM_SCRATCH, store->reloadDistancesPath);
+	store->reloadVerticesPath = vertices;
+	store->reloadDistancesPath = distances;
+
+	atomic_store(&store->reloading, 1);
+	if (pthread_create(&store->reloadThread, NULL, reload_thread_main, store) != 0) {
+		atomic_store(&store->reloading, 0);
+		return -1;
+	}
+	store->reloadThreadJoinable = 1;
+	return 1;
+}
+
+/*
+ * graph_store_wait_reload
+ * 	Join the reload thread if one was started and not yet joined.
+ */
+void graph_store_wait_reload(GraphStore *store) {
+	if (store == NULL || !store->reloadThreadJoinable) {
+		return;
+	}
+	pthread_join(store->reloadThread, NULL);
+	store->reloadThreadJoinable = 0;
+}
+
+/*
+ * graph_store_take_reload_result
+ * 	Return the outcome of the last finished reload and reset it to
+ * 	RELOAD_NONE so each result is reported once.
+ */
+ReloadResult graph_store_take_reload_result(GraphStore *store) {
+	if (store == NULL) {
+		return RELOAD_NONE;
+	}
+	return (ReloadResult)atomic_exchange(&store->reloadResult, RELOAD_NONE);
+}
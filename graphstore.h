@@ -0,0 +1,97 @@
+#ifndef GRAPHSTORE_H
+#define GRAPHSTORE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "graph.h"
+#include "engine.h"
+#include "nameindex.h"
+
+// Maximum number of threads that may read from one store at a time.
+#define GRAPH_STORE_MAX_READERS 64
+
+// An immutable, published graph plus everything derived from it.
+// Readers must not keep pointers into a version after graph_store_exit.
+typedef struct {
+	Graph *graph;
+	unsigned long generation;   // 1 for the initial graph, +1 per reload
+	const RoutingEngine *engine;
+	void *engineState;          // prepared for 'graph'; freed with the version
+	NameIndex *names;           // sorted name index over 'graph'
+	EdgeCompaction compaction;  // edges dropped while loading 'graph'
+} GraphVersion;
+
+// Outcome of the most recent background reload, consumed by
+// graph_store_take_reload_result.
+typedef enum {
+	RELOAD_NONE = 0,
+	RELOAD_SUCCEEDED,
+	RELOAD_FAILED
+} ReloadResult;
+
+// Holds the active graph version and swaps it without stopping readers.
+//
+// Reclamation is epoch based (RCU style): a reader publishes the global
+// epoch in its slot before loading the current version, and clears the slot
+// when it is done. After swapping in a new version the writer advances the
+// epoch and waits until every slot is either quiescent (0) or has seen the
+// new epoch; only then can no reader still hold the old version, so it is
+// freed. Readers never block or take locks.
+typedef struct {
+	_Atomic(GraphVersion *) current;
+	atomic_ulong epoch;
+	atomic_ulong readerEpochs[GRAPH_STORE_MAX_READERS];   // 0 = quiescent
+	atomic_int readerInUse[GRAPH_STORE_MAX_READERS];
+	atomic_int reloading;          // 1 while a background reload runs
+	atomic_int reloadResult;       // ReloadResult of the last finished reload
+	pthread_t reloadThread;
+	int reloadThreadJoinable;      // only touched by the controlling thread
+	char *reloadVerticesPath;
+	char *reloadDistancesPath;
+	char *engineName;              // "auto" or a registered engine name
+	long expectedQueries;          // hint for automatic engine selection
+	int ingestThreads;             // parser threads for reloads (0 = sequential)
+} GraphStore;
+
+// Creates a store that takes ownership of 'initial' and its name index
+// 'initialNames' (built here when NULL) and prepares the named engine
+// ("auto" or a registered name) for it, and for every reloaded graph.
+// Reloads load with 'ingestThreads' parsers, as in load_graph.
+// Returns NULL on failure (in which case neither 'initial' nor
+// 'initialNames' is freed).
+GraphStore *graph_store_create(Graph *initial, NameIndex *initialNames, const char *engineName, long expectedQueries, int ingestThreads);
+
+// Waits for any running reload, then frees the store and the active version.
+// All readers must have been unregistered.
+void graph_store_free(GraphStore *store);
+
+// Claims a reader slot for the calling thread. Returns the slot or -1 if all
+// slots are taken.
+int graph_store_register_reader(GraphStore *store);
+void graph_store_unregister_reader(GraphStore *store, int slot);
+
+// Begins a read-side critical section and returns the active version, which
+// stays valid until graph_store_exit is called with the same slot.
+const GraphVersion *graph_store_enter(GraphStore *store, int slot);
+void graph_store_exit(GraphStore *store, int slot);
+
+// Generation of the active version. Call between graph_store_enter and
+// graph_store_exit: a result that differs from the entered version's means
+// that version has been replaced and will be freed after graph_store_exit.
+unsigned long graph_store_generation(GraphStore *store);
+
+// Starts building a graph from the given files on a background thread.
+// On success the new version is swapped in and the old one is freed once
+// all readers have left it.
+// Returns 1 if the reload started, 0 if one is already running, -1 on
+// invalid input, allocation failure or if the thread could not be created.
+int graph_store_reload_async(GraphStore *store, const char *verticesFilePath, const char *distancesFilePath);
+
+// Blocks until the running reload (if any) has finished.
+void graph_store_wait_reload(GraphStore *store);
+
+// Returns and clears the result of the last finished reload.
+ReloadResult graph_store_take_reload_result(GraphStore *store);
+
+#endif
@@ -0,0 +1,625 @@
+#include "hublabel.h"
+
+#include "dijkstra.h"
+#include "search.h"
+#include "memstat.h"
+#include "querylog.h"
+/*
+ * Hub labeling
+ *
+ * Pruned landmark labeling (Akiba et al.): vertices are processed in order
+ * of decreasing degree, and a Dijkstra search from each one adds it as a hub
+ * to every vertex it reaches, except where the labels built so far already
+ * prove a distance at least as short. The resulting labels answer a
+ * distance query with a single merge of two short sorted arrays.
+ */
+
+/*
+ * DynamicLabel
+ * 	Growable label used while building; compacted into the flat index at
+ * 	the end. Build-time memory is charged to MEM_SCRATCH, the flat index to
+ * 	MEM_INDEX.
+ */
+typedef struct {
+	int *rank;
+	int *distance;
+	int *parent;
+	int size;
+	int capacity;
+} DynamicLabel;
+
+/*
+ * BuildState
+ * 	Scratch memory for the pruned searches, reused for every root; the
+ * 	searches run in one workspace through search_settle. liveBytes counts
+ * 	everything the build holds (the index under construction and the
+ * 	workspace's growth included) and is checked against maxBytes before
+ * 	every allocation, so a capped build fails before it outgrows the cap.
+ */
+typedef struct {
+	const Graph *graph;
+	DynamicLabel *labels;     // size numVertices
+	int *rootDistance;        // indexed by hub rank, INF_DISTANCE when unset
+	SearchWorkspace *ws;
+	int rank;                 // hub rank of the current root
+	int status;               // why the current search failed: 0 cap, -1 allocation
+	long long numEntries;
+	int truncated;            // a relaxation reached INF_DISTANCE
+	size_t liveBytes;
+	size_t peakBytes;
+	size_t maxBytes;          // 0 = unlimited
+} BuildState;
+
+// Bytes held per label entry: rank, distance and parent.
+#define BYTES_PER_ENTRY (3 * sizeof(int))
+
+/*
+ * index_bytes
+ * 	Memory used by an index with 'entries' label entries over 'n' vertices.
+ */
+static size_t index_bytes(int n, long long entries) {
+	return sizeof(HubLabelIndex) + (size_t)n * sizeof(int) + (size_t)(n + 1) * sizeof(int)
+		+ (size_t)entries * BYTES_PER_ENTRY;
+}
+
+/*
+ * reserve_bytes
+ * 	Charge 'bytes' to the build if that keeps it within the cap.
+ *
+ * Returns:
+ * 	1 if charged, 0 if the cap would be exceeded (nothing is charged).
+ */
+static int reserve_bytes(BuildState *state, size_t bytes) {
+	if (state->maxBytes > 0 && state->liveBytes + bytes > state->maxBytes) {
+		return 0;
+	}
+	state->liveBytes += bytes;
+	if (state->liveBytes > state->peakBytes) {
+		state->peakBytes = state->liveBytes;
+	}
+	return 1;
+}
+
+/*
+ * release_bytes
+ * 	Return bytes charged with reserve_bytes.
+ */
+static void release_bytes(BuildState *state, size_t bytes) {
+	state->liveBytes -= bytes;
+}
+
+/*
+ * gate_reserve
+ * 	Workspace growth gate: charge the search scratch to the build, noting
+ * 	a refusal as a cap failure.
+ */
+static int gate_reserve(void *context, size_t bytes) {
+	BuildState *state = (BuildState *)context;
+	if (!reserve_bytes(state, bytes)) {
+		state->status = 0;
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * gate_release
+ * 	Workspace growth gate: return freed search scratch to the build.
+ */
+static void gate_release(void *context, size_t bytes) {
+	release_bytes((BuildState *)context, bytes);
+}
+
+/*
+ * label_append
+ * 	Append (rank, distance, parent) to a dynamic label.
+ *
+ * Returns:
+ * 	1 on success, 0 if growing the label would exceed the cap, -1 on
+ * 	allocation failure.
+ */
+static int label_append(BuildState *state, DynamicLabel *label, int rank, int distance, int parent) {
+	if (label->size >= label->capacity) {
+		int newCapacity = label->capacity > 0 ? label->capacity * 2 : 4;
+		size_t oldBytes = (size_t)label->capacity * sizeof(int);
+		size_t newBytes = (size_t)newCapacity * sizeof(int);
+		// Old and new arrays coexist while copying; charge both
+		if (!reserve_bytes(state, 3 * newBytes)) {
+			return 0;
+		}
+		void *oldArrays[3] = { label->rank, label->distance, label->parent };
+		void *newArrays[3];
+		if (!mem_grow_together(MEM_SCRATCH, oldArrays, newArrays, 3, oldBytes, newBytes)) {
+			release_bytes(state, 3 * newBytes);
+			return -1;
+		}
+		release_bytes(state, 3 * oldBytes);
+		label->rank = (int *)newArrays[0];
+		label->distance = (int *)newArrays[1];
+		label->parent = (int *)newArrays[2];
+		label->capacity = newCapacity;
+	}
+	label->rank[label->size] = rank;
+	label->distance[label->size] = distance;
+	label->parent[label->size] = parent;
+	label->size++;
+	return 1;
+}
+
+/*
+ * visit_vertex
+ * 	search_settle visitor of the pruned search. A vertex u reached at
+ * 	distance d is settled without being expanded when the current labels
+ * 	of the root and u already certify a distance <= d; otherwise the root
+ * 	is added to u's label.
+ *
+ * Returns:
+ * 	1 to expand u, 0 if pruned, -1 to abort (reason in state->status).
+ */
+static int visit_vertex(void *context, int vertex, int distance, int parent) {
+	BuildState *state = (BuildState *)context;
+	DynamicLabel *label = &state->labels[vertex];
+	for (int i = 0; i < label->size; i++) {
+		int viaHub = state->rootDistance[label->rank[i]];
+		if (viaHub < INF_DISTANCE && (long long)viaHub + label->distance[i] <= distance) {
+			return 0;
+		}
+	}
+	int status = label_append(state, label, state->rank, distance, parent);
+	if (status != 1) {
+		state->status = status;
+		return -1;
+	}
+	state->numEntries++;
+	return 1;
+}
+
+/*
+ * pruned_search
+ * 	Pruned Dijkstra from 'root' (hub rank 'rank'); see visit_vertex.
+ *
+ * Returns:
+ * 	1 on success, 0 if the memory cap was hit, -1 on allocation failure.
+ */
+static int pruned_search(BuildState *state, int root, int rank) {
+	DynamicLabel *rootLabel = &state->labels[root];
+	for (int i = 0; i < rootLabel->size; i++) {
+		state->rootDistance[rootLabel->rank[i]] = rootLabel->distance[i];
+	}
+	state->rank = rank;
+	state->status = -1; // unless the cap or a label says otherwise
+	int result = search_settle(state->ws, root, INF_DISTANCE - 1, visit_vertex, state);
+	if (result == 2) {
+		state->truncated = 1;
+	}
+	for (int i = 0; i < rootLabel->size; i++) {
+		state->rootDistance[rootLabel->rank[i]] = INF_DISTANCE;
+	}
+	return result > 0 ? 1 : state->status;
+}
+
+/*
+ * free_build_state
+ * 	Release all scratch and dynamic labels. Safe to call with NULL.
+ */
+static void free_build_state(BuildState *state) {
+	if (state == NULL) {
+		return;
+	}
+	size_t n = (size_t)state->graph->numVertices;
+	if (state->labels != NULL) {
+		for (size_t i = 0; i < n; i++) {
+			size_t labelBytes = (size_t)state->labels[i].capacity * sizeof(int);
+			mem_free(MEM_SCRATCH, state->labels[i].rank, labelBytes);
+			mem_free(MEM_SCRATCH, state->labels[i].distance, labelBytes);
+			mem_free(MEM_SCRATCH, state->labels[i].parent, labelBytes);
+		}
+	}
+	mem_free(MEM_SCRATCH, state->labels, n * sizeof(DynamicLabel));
+	mem_free(MEM_SCRATCH, state->rootDistance, n * sizeof(int));
+	search_workspace_free(state->ws);
+	mem_free(MEM_SCRATCH, state, sizeof(BuildState));
+}
+
+/*
+ * create_build_state
+ * 	Allocate scratch memory for building labels over 'graph', charging it
+ * 	to the build along with the 'indexBytes' already held by the index.
+ *
+ * Returns:
+ * 	1 on success (*outState set), 0 if the fixed arrays alone exceed
+ * 	'maxBytes', -1 on allocation failure.
+ */
+static int create_build_state(const Graph *graph, size_t maxBytes, size_t indexBytes, BuildState **outState) {
+	int n = graph->numVertices;
+	// Root distances plus the workspace's distance and predecessor arrays;
+	// its touched list and heap are charged through the gate as they grow
+	size_t fixedBytes = sizeof(BuildState) + sizeof(SearchWorkspace) + (size_t)n * (sizeof(DynamicLabel) + 3 * sizeof(int));
+	if (maxBytes > 0 && indexBytes + fixedBytes > maxBytes) {
+		return 0;
+	}
+	BuildState *state = (BuildState *)mem_calloc(MEM_SCRATCH, 1, sizeof(BuildState));
+	if (state == NULL) {
+		return -1;
+	}
+	state->graph = graph;
+	state->maxBytes = maxBytes;
+	state->liveBytes = indexBytes + fixedBytes;
+	state->peakBytes = state->liveBytes;
+	state->labels = (DynamicLabel *)mem_calloc(MEM_SCRATCH, (size_t)n, sizeof(DynamicLabel));
+	state->rootDistance = (int *)mem_malloc(MEM_SCRATCH, (size_t)n * sizeof(int));
+	state->ws = search_workspace_create(graph, MEM_SCRATCH);
+	if (state->labels == NULL || state->rootDistance == NULL || state->ws == NULL) {
+		free_build_state(state);
+		return -1;
+	}
+	search_workspace_set_gate(state->ws, gate_reserve, gate_release, state);
+	for (int i = 0; i < n; i++) {
+		state->rootDistance[i] = INF_DISTANCE;
+	}
+	*outState = state;
+	return 1;
+}
+
+/*
+ * RankedVertex
+ * 	Sort key for the hub order; the degree travels with the vertex so the
+ * 	comparator needs no shared state.
+ */
+typedef struct {
+	int degree;
+	int vertex;
+} RankedVertex;
+
+/*
+ * compare_by_degree
+ * 	qsort comparator: higher degree first, ties by lower vertex index.
+ */
+static int compare_by_degree(const void *a, const void *b) {
+	const RankedVertex *x = (const RankedVertex *)a;
+	const RankedVertex *y = (const RankedVertex *)b;
+	if (x->degree != y->degree) {
+		return y->degree - x->degree;
+	}
+	return x->vertex - y->vertex;
+}
+
+/*
+ * compute_order
+ * 	Fill 'order' with vertices sorted by decreasing degree, so hubs that
+ * 	cover many shortest paths are labeled first and prune later searches.
+ *
+ * Returns:
+ * 	1 on success, 0 if the sort keys would exceed the cap, -1 on
+ * 	allocation failure.
+ */
+static int compute_order(BuildState *state, int *order) {
+	const Graph *graph = state->graph;
+	int n = graph->numVertices;
+	size_t keyBytes = (size_t)n * sizeof(RankedVertex);
+	if (!reserve_bytes(state, keyBytes)) {
+		return 0;
+	}
+	RankedVertex *keys = (RankedVertex *)mem_malloc(MEM_SCRATCH, keyBytes);
+	if (keys == NULL) {
+		return -1;
+	}
+	for (int v = 0; v < n; v++) {
+		keys[v].degree = 0;
+		keys[v].vertex = v;
+		for (Edge *e = graph->adjacency[v]; e != NULL; e = e->next) {
+			keys[v].degree++;
+		}
+	}
+	qsort(keys, (size_t)n, sizeof(RankedVertex), compare_by_degree);
+	for (int i = 0; i < n; i++) {
+		order[i] = keys[i].vertex;
+	}
+	mem_free(MEM_SCRATCH, keys, keyBytes);
+	release_bytes(state, keyBytes);
+	return 1;
+}
+
+/*
+ * hub_label_free
+ * 	Release the index. Safe to call with NULL.
+ */
+void hub_label_free(HubLabelIndex *index) {
+	if (index == NULL) {
+		return;
+	}
+	size_t n = (size_t)index->numVertices;
+	size_t entryBytes = (size_t)(index->numEntries > 0 ? index->numEntries : 1) * sizeof(int);
+	mem_free(MEM_INDEX, index->order, n * sizeof(int));
+	mem_free(MEM_INDEX, index->labelOffset, (n + 1) * sizeof(int));
+	mem_free(MEM_INDEX, index->hubRank, entryBytes);
+	mem_free(MEM_INDEX, index->hubDistance, entryBytes);
+	mem_free(MEM_INDEX, index->hubParent, entryBytes);
+	mem_free(MEM_INDEX, index, sizeof(HubLabelIndex));
+}
+
+/*
+ * label_field
+ * 	One of a dynamic label's parallel arrays: 0 rank, 1 distance, 2 parent.
+ */
+static int **label_field(DynamicLabel *label, int field) {
+	if (field == 0) {
+		return &label->rank;
+	}
+	return field == 1 ? &label->distance : &label->parent;
+}
+
+/*
+ * compact_labels
+ * 	Copy the dynamic labels into the flat arrays of 'index' one field at
+ * 	a time, freeing each label's copy of a field as soon as it has been
+ * 	copied, so only one field is ever held twice. Every flat array is
+ * 	charged to the build before it is allocated.
+ *
+ * Returns:
+ * 	1 on success, 0 if a flat array would exceed the cap, -1 on
+ * 	allocation failure.
+ */
+static int compact_labels(BuildState *state, HubLabelIndex *index) {
+	int n = index->numVertices;
+	size_t entries = (size_t)state->numEntries;
+	size_t entryBytes = (entries > 0 ? entries : 1) * sizeof(int);
+	if (!reserve_bytes(state, (size_t)(n + 1) * sizeof(int))) {
+		return 0;
+	}
+	// hub_label_free releases the entry arrays by numEntries; set it first
+	index->numEntries = (long long)entries;
+	index->labelOffset = (int *)mem_malloc(MEM_INDEX, (size_t)(n + 1) * sizeof(int));
+	if (index->labelOffset == NULL) {
+		return -1;
+	}
+	int offset = 0;
+	for (int v = 0; v < n; v++) {
+		index->labelOffset[v] = offset;
+		offset += state->labels[v].size;
+	}
+	index->labelOffset[n] = offset;
+
+	int **flatFields[3] = { &index->hubRank, &index->hubDistance, &index->hubParent };
+	for (int field = 0; field < 3; field++) {
+		if (!reserve_bytes(state, entryBytes)) {
+			return 0;
+		}
+		int *flat = (int *)mem_malloc(MEM_INDEX, entryBytes);
+		if (flat == NULL) {
+			return -1;
+		}
+		*flatFields[field] = flat;
+		for (int v = 0; v < n; v++) {
+			DynamicLabel *label = &state->labels[v];
+			int **source = label_field(label, field);
+			size_t labelBytes = (size_t)label->capacity * sizeof(int);
+			memcpy(flat + index->labelOffset[v], *source, (size_t)label->size * sizeof(int));
+			mem_free(MEM_SCRATCH, *source, labelBytes);
+			*source = NULL;
+			release_bytes(state, labelBytes);
+		}
+	}
+	return 1;
+}
+
+/*
+ * hub_label_build
+ * 	Run one pruned search per vertex in rank order, then compact.
+ *
+ * Returns:
+ * 	1 on success, 0 if 'maxBytes' was exceeded, -1 on invalid input or
+ * 	allocation failure.
+ */
+int hub_label_build(const Graph *graph, size_t maxBytes, HubLabelIndex **outIndex, HubLabelStats *outStats) {
+	if (graph == NULL || graph->numVertices <= 0 || outIndex == NULL) {
+		return -1;
+	}
+	long long start = query_log_now_us();
+	int n = graph->numVertices;
+	HubLabelIndex *index = (HubLabelIndex *)mem_calloc(MEM_INDEX, 1, sizeof(HubLabelIndex));
+	if (index == NULL) {
+		return -1;
+	}
+	BuildState *state = NULL;
+	int status = create_build_state(graph, maxBytes, sizeof(HubLabelIndex) + (size_t)n * sizeof(int), &state);
+	if (status != 1) {
+		mem_free(MEM_INDEX, index, sizeof(HubLabelIndex));
+		return status;
+	}
+	index->numVertices = n;
+	index->order = (int *)mem_malloc(MEM_INDEX, (size_t)n * sizeof(int));
+	status = index->order != NULL ? compute_order(state, index->order) : -1;
+	for (int rank = 0; rank < n && status == 1; rank++) {
+		status = pruned_search(state, index->order[rank], rank);
+	}
+	if (status == 1) {
+		status = compact_labels(state, index);
+	}
+	size_t peakBytes = state->peakBytes;
+	index->truncated = state->truncated;
+	free_build_state(state);
+	if (status != 1) {
+		hub_label_free(index);
+		return status;
+	}
+
+	if (outStats != NULL) {
+		int maxLabel = 0;
+		for (int v = 0; v < n; v++) {
+			int size = index->labelOffset[v + 1] - index->labelOffset[v];
+			if (size > maxLabel) {
+				maxLabel = size;
+			}
+		}
+		outStats->numEntries = index->numEntries;
+		outStats->averageLabelSize = (double)index->numEntries / n;
+		outStats->maxLabelSize = maxLabel;
+		outStats->bytes = index_bytes(n, index->numEntries);
+		outStats->peakBuildBytes = peakBytes;
+		outStats->buildMs = (query_log_now_us() - start) / 1000.0;
+	}
+	*outIndex = index;
+	return 1;
+}
+
+/*
+ * best_common_hub
+ * 	Merge-intersect the labels of s and t.
+ *
+ * Returns:
+ * 	Smallest s-hub-t distance (INF_DISTANCE or more if none) and, via
+ * 	outRank, the hub rank achieving it.
+ */
+static long long best_common_hub(const HubLabelIndex *index, int s, int t, int *outRank) {
+	int i = index->labelOffset[s];
+	int iEnd = index->labelOffset[s + 1];
+	int j = index->labelOffset[t];
+	int jEnd = index->labelOffset[t + 1];
+	long long best = INF_DISTANCE;
+	int bestRank = -1;
+	while (i < iEnd && j < jEnd) {
+		int ri = index->hubRank[i];
+		int rj = index->hubRank[j];
+		if (ri < rj) {
+			i++;
+		} else if (ri > rj) {
+			j++;
+		} else {
+			long long d = (long long)index->hubDistance[i] + index->hubDistance[j];
+			if (d < best) {
+				best = d;
+				bestRank = ri;
+			}
+			i++;
+			j++;
+		}
+	}
+	*outRank = bestRank;
+	return best;
+}
+
+/*
+ * miss_status
+ * 	Status for a pair with no usable common hub: a route of INF_DISTANCE or
+ * 	more may exist when the build left such routes out, or when the best
+ * 	common hub is that far.
+ */
+static int miss_status(const HubLabelIndex *index, int rank) {
+	return rank >= 0 || index->truncated ? DIJKSTRA_TOO_LONG : 0;
+}
+
+/*
+ * find_entry
+ * 	Binary search the label of 'v' for hub 'rank'.
+ *
+ * Returns:
+ * 	Entry position in the flat arrays, or -1 if 'rank' is not in the label.
+ */
+static int find_entry(const HubLabelIndex *index, int v, int rank) {
+	int lo = index->labelOffset[v];
+	int hi = index->labelOffset[v + 1] - 1;
+	while (lo <= hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (index->hubRank[mid] == rank) {
+			return mid;
+		}
+		if (index->hubRank[mid] < rank) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return -1;
+}
+
+/*
+ * hub_label_distance
+ * 	Distance lookup via a single label merge.
+ */
+int hub_label_distance(const HubLabelIndex *index, int s, int t, int *outDistance) {
+	if (index == NULL || outDistance == NULL || s < 0 || s >= index->numVertices || t < 0 || t >= index->numVertices) {
+		return -1;
+	}
+	int rank;
+	long long best = best_common_hub(index, s, t, &rank);
+	if (rank < 0 || best >= INF_DISTANCE) {
+		return miss_status(index, rank);
+	}
+	*outDistance = (int)best;
+	return 1;
+}
+
+/*
+ * walk_to_hub
+ * 	Follow hub parents from 'v' up to (excluding) the hub vertex of 'rank'.
+ * 	With 'out' NULL the walk is only measured; otherwise vertex i of the
+ * 	walk is written to out[i * step], so step -1 writes it backwards.
+ *
+ * Returns:
+ * 	Number of vertices on the walk, or -1 if the parent chain is broken.
+ */
+static int walk_to_hub(const HubLabelIndex *index, int v, int rank, int *out, int step) {
+	int hub = index->order[rank];
+	int count = 0;
+	for (int cur = v; cur != hub; count++) {
+		int entry = find_entry(index, cur, rank);
+		// A shortest path is simple, so a longer walk means a broken chain
+		if (entry < 0 || count >= index->numVertices) {
+			return -1;
+		}
+		if (out != NULL) {
+			out[count * step] = cur;
+		}
+		cur = index->hubParent[entry];
+	}
+	return count;
+}
+
+/*
+ * hub_label_path
+ * 	Find the best common hub h of s and t, then build
+ * 	s -> ... -> h -> ... -> t from the parent chains of both labels. Costs
+ * 	O(path length x log label size); nothing is sized by V.
+ *
+ * Returns:
+ * 	1 if a path is found, 0 if t is unreachable, DIJKSTRA_TOO_LONG (see
+ * 	miss_status), -1 on invalid input or allocation failure.
+ *
+ * Notes:
+ * 	Caller owns and must free(*outPath) when return value > 0.
+ */
+int hub_label_path(const HubLabelIndex *index, int s, int t, int **outPath, int *outPathLen, int *outTotalDistance) {
+	if (index == NULL || outPath == NULL || outPathLen == NULL || outTotalDistance == NULL) {
+		return -1;
+	}
+	int n = index->numVertices;
+	if (s < 0 || s >= n || t < 0 || t >= n) {
+		return -1;
+	}
+	int rank;
+	long long best = best_common_hub(index, s, t, &rank);
+	if (rank < 0 || best >= INF_DISTANCE) {
+		return miss_status(index, rank);
+	}
+
+	// Measure both halves first so only the path itself is allocated
+	int forwardLen = walk_to_hub(index, s, rank, NULL, 1);
+	int backwardLen = walk_to_hub(index, t, rank, NULL, 1);
+	if (forwardLen < 0 || backwardLen < 0) {
+		return -1;
+	}
+	int pathLen = forwardLen + backwardLen + 1;
+	int *path = (int *)malloc((size_t)pathLen * sizeof(int));
+	if (path == NULL) {
+		return -1;
+	}
+	walk_to_hub(index, s, rank, path, 1);
+	path[forwardLen] = index->order[rank];
+	walk_to_hub(index, t, rank, path + pathLen - 1, -1);
+
+	*outPath = path;
+	*outPathLen = pathLen;
+	*outTotalDistance = (int)best;
+	return 1;
+}
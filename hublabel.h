@@ -0,0 +1,59 @@
+#ifndef HUBLABEL_H
+#define HUBLABEL_H
+
+#include <stddef.h>
+
+#include "graph.h"
+
+// Hub labeling index built with pruned landmark labeling.
+// Every vertex stores a label: a list of (hub, distance) pairs sorted by hub
+// rank, such that for any s, t some hub on a shortest s-t path appears in
+// both labels. All labels live in flat arrays indexed by labelOffset.
+typedef struct {
+	int numVertices;
+	int *order;           // rank -> vertex (rank 0 is the most important hub)
+	int *labelOffset;     // size numVertices + 1
+	int *hubRank;         // ascending within each label
+	int *hubDistance;     // distance from the vertex to the hub
+	int *hubParent;       // next vertex towards the hub (-1 at the hub itself)
+	long long numEntries;
+	int truncated;        // the build skipped routes of INF_DISTANCE or more
+} HubLabelIndex;
+
+// Figures reported after a build.
+typedef struct {
+	long long numEntries;
+	double averageLabelSize;
+	int maxLabelSize;
+	size_t bytes;         // memory held by the index
+	size_t peakBuildBytes; // most memory held at once while building, index included
+	double buildMs;       // wall time spent building
+} HubLabelStats;
+
+// hub_label_build:
+//   Builds labels by running a pruned Dijkstra from every vertex in order of
+//   decreasing degree. Fails cleanly, before allocating past it, when the
+//   build would hold more than 'maxBytes' at once: growing labels, search
+//   scratch and the final index all count (0 disables the cap).
+// Returns:
+//   1 on success (outIndex set, outStats filled if non-NULL),
+//   0 if the memory cap was exceeded,
+//  -1 on invalid input or allocation failure.
+//   Caller frees the index with hub_label_free.
+int hub_label_build(const Graph *graph, size_t maxBytes, HubLabelIndex **outIndex, HubLabelStats *outStats);
+void hub_label_free(HubLabelIndex *index);
+
+// hub_label_distance:
+//   Merge-intersects the labels of s and t.
+// Returns:
+//   1 and sets outDistance if t is reachable from s, 0 otherwise,
+//   DIJKSTRA_TOO_LONG if the route may be INF_DISTANCE or longer,
+//  -1 on invalid input.
+int hub_label_distance(const HubLabelIndex *index, int s, int t, int *outDistance);
+
+// hub_label_path:
+//   Same contract as dijkstra_shortest_path. The path is rebuilt by walking
+//   hub parents from s and from t towards their best common hub.
+int hub_label_path(const HubLabelIndex *index, int s, int t, int **outPath, int *outPathLen, int *outTotalDistance);
+
+#endif
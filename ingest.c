@@ -0,0 +1,797 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ingest.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "memstat.h"
+#include "nameindex.h"
+#include "querylog.h"
+/*
+ * Pipelined ingest
+ *
+ * Loads a graph with file reading, parsing and construction overlapped:
+ *
+ * 	vertices file -> reader -> [chunks] -> vertex stage --(graph, name index)--.
+ * 	                                                                           v
+ * 	distances file -> reader -> [chunks] -> parser x N -> [edge batches] -> builder
+ *
+ * Readers cut the file into chunks of whole lines. Distance parsers tokenize
+ * their chunks while the vertex file is still loading and only wait for the
+ * name index before resolving city names. Every queue is bounded, so a slow
+ * stage throttles the ones before it instead of letting the whole file pile
+ * up in memory. Any failure aborts the pipeline by closing all queues.
+ */
+
+// Bytes requested per read(); a chunk grows past this only to fit a longer
+// line. Small enough that even a modest file splits into several chunks for
+// the parsers, while the readahead hints keep the disk streaming.
+#define CHUNK_BYTES (64 * 1024)
+
+// Queue depths between stages.
+#define CHUNK_QUEUE_DEPTH 8
+#define BATCH_QUEUE_DEPTH 8
+
+/*
+ * Chunk
+ * 	Whole lines of one file; data has capacity + 1 bytes so the last line
+ * 	can be NUL-terminated in place.
+ */
+typedef struct {
+	char *data;
+	size_t length;
+	size_t capacity;
+} Chunk;
+
+/*
+ * EdgeBatch
+ * 	Resolved edges of one chunk as (u, v, weight) triples.
+ */
+typedef struct {
+	int *triples;
+	int count;
+	int capacity;
+} EdgeBatch;
+
+/*
+ * BoundedQueue
+ * 	Fixed-capacity FIFO of pointers. Pushing blocks while full, popping
+ * 	blocks while empty; once closed, pushes fail and pops drain what is
+ * 	left and then return NULL.
+ */
+typedef struct {
+	void **items;
+	int capacity;
+	int head;
+	int count;
+	int closed;
+	pthread_mutex_t lock;
+	pthread_cond_t notEmpty;
+	pthread_cond_t notFull;
+} BoundedQueue;
+
+/*
+ * IngestContext
+ * 	State shared by all stages of one ingest_graph call.
+ */
+typedef struct {
+	BoundedQueue vertexChunks;
+	BoundedQueue distanceChunks;
+	BoundedQueue batches;
+	pthread_mutex_t lock;          // guards the fields below
+	pthread_cond_t verticesReady;
+	int verticesDone;              // graph and names are final (or the load failed)
+	int failed;
+	Graph *graph;
+	NameIndex *names;
+	double vertexMs;
+	double buildMs;
+	double builderIdleMs;
+	long long edges;
+} IngestContext;
+
+typedef struct {
+	IngestContext *ctx;
+	const char *path;
+	BoundedQueue *queue;
+	double readMs;
+	size_t bytesRead;
+} ReaderTask;
+
+typedef struct {
+	IngestContext *ctx;
+	double parseMs;
+	long long skippedLines;
+} ParserTask;
+
+/*
+ * queue_init
+ * 	Returns 1 on success, 0 on allocation or initialization failure.
+ */
+static int queue_init(BoundedQueue *queue, int capacity) {
+	memset(queue, 0, sizeof(*queue));
+	queue->items = (void **)mem_calloc(MEM_SCRATCH, (size_t)capacity, sizeof(void *));
+	if (queue->items == NULL) {
+		return 0;
+	}
+	queue->capacity = capacity;
+	if (pthread_mutex_init(&queue->lock, NULL) != 0) {
+		mem_free(MEM_SCRATCH, queue->items, (size_t)capacity * sizeof(void *));
+		return 0;
+	}
+	pthread_cond_init(&queue->notEmpty, NULL);
+	pthread_cond_init(&queue->notFull, NULL);
+	return 1;
+}
+
+static void queue_destroy(BoundedQueue *queue) {
+	pthread_cond_destroy(&queue->notFull);
+	pthread_cond_destroy(&queue->notEmpty);
+	pthread_mutex_destroy(&queue->lock);
+	mem_free(MEM_SCRATCH, queue->items, (size_t)queue->capacity * sizeof(void *));
+}
+
+/*
+ * queue_push
+ * 	Returns 1 once 'item' is queued, 0 if the queue was closed (the caller
+ * 	still owns 'item').
+ */
+static int queue_push(BoundedQueue *queue, void *item) {
+	pthread_mutex_lock(&queue->lock);
+	while (queue->count == queue->capacity && !queue->closed) {
+		pthread_cond_wait(&queue->notFull, &queue->lock);
+	}
+	if (queue->closed) {
+		pthread_mutex_unlock(&queue->lock);
+		return 0;
+	}
+	queue->items[(queue->head + queue->count) % queue->capacity] = item;
+	queue->count++;
+	pthread_cond_signal(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+	return 1;
+}
+
+/*
+ * queue_pop
+ * 	Returns the oldest item, or NULL once the queue is closed and empty.
+ */
+static void *queue_pop(BoundedQueue *queue) {
+	pthread_mutex_lock(&queue->lock);
+	while (queue->count == 0 && !queue->closed) {
+		pthread_cond_wait(&queue->notEmpty, &queue->lock);
+	}
+	void *item = NULL;
+	if (queue->count > 0) {
+		item = queue->items[queue->head];
+		queue->head = (queue->head + 1) % queue->capacity;
+		queue->count--;
+		pthread_cond_signal(&queue->notFull);
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return item;
+}
+
+static void queue_close(BoundedQueue *queue) {
+	pthread_mutex_lock(&queue->lock);
+	queue->closed = 1;
+	pthread_cond_broadcast(&queue->notEmpty);
+	pthread_cond_broadcast(&queue->notFull);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+static Chunk *chunk_create(size_t capacity) {
+	Chunk *chunk = (Chunk *)mem_malloc(MEM_SCRATCH, sizeof(Chunk));
+	if (chunk == NULL) {
+		return NULL;
+	}
+	chunk->data = (char *)mem_malloc(MEM_SCRATCH, capacity + 1);
+	if (chunk->data == NULL) {
+		mem_free(MEM_SCRATCH, chunk, sizeof(Chunk));
+		return NULL;
+	}
+	chunk->length = 0;
+	chunk->capacity = capacity;
+	return chunk;
+}
+
+static void chunk_free(Chunk *chunk) {
+	if (chunk == NULL) {
+		return;
+	}
+	mem_free(MEM_SCRATCH, chunk->data, chunk->capacity + 1);
+	mem_free(MEM_SCRATCH, chunk, sizeof(Chunk));
+}
+
+/*
+ * chunk_grow
+ * 	Double a chunk's capacity for a line that does not fit.
+ *
+ * Returns:
+ * 	1 on success, 0 on allocation failure.
+ */
+static int chunk_grow(Chunk *chunk) {
+	size_t newCapacity = chunk->capacity * 2;
+	char *data = (char *)mem_realloc(MEM_SCRATCH, chunk->data, chunk->capacity + 1, newCapacity + 1);
+	if (data == NULL) {
+		return 0;
+	}
+	chunk->data = data;
+	chunk->capacity = newCapacity;
+	return 1;
+}
+
+static void batch_free(EdgeBatch *batch) {
+	if (batch == NULL) {
+		return;
+	}
+	mem_free(MEM_SCRATCH, batch->triples, (size_t)batch->capacity * 3 * sizeof(int));
+	mem_free(MEM_SCRATCH, batch, sizeof(EdgeBatch));
+}
+
+/*
+ * abort_ingest
+ * 	Mark the load as failed and close every queue so all stages drain and
+ * 	exit; wakes parsers waiting for the vertex stage.
+ */
+static void abort_ingest(IngestContext *ctx) {
+	pthread_mutex_lock(&ctx->lock);
+	ctx->failed = 1;
+	ctx->verticesDone = 1;
+	pthread_cond_broadcast(&ctx->verticesReady);
+	pthread_mutex_unlock(&ctx->lock);
+	queue_close(&ctx->vertexChunks);
+	queue_close(&ctx->distanceChunks);
+	queue_close(&ctx->batches);
+}
+
+/*
+ * reader_main
+ * 	Read one file with large sequential reads and queue it as chunks of
+ * 	whole lines; a partial last line is carried into the next chunk.
+ */
+static void *reader_main(void *arg) {
+	ReaderTask *task = (ReaderTask *)arg;
+	int fd = open(task->path, O_RDONLY);
+	if (fd < 0) {
+		abort_ingest(task->ctx);
+		return NULL;
+	}
+#ifdef POSIX_FADV_SEQUENTIAL
+	// Readahead hints; purely advisory, so failures are ignored
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+	Chunk *pending = chunk_create(CHUNK_BYTES);
+	int ok = pending != NULL;
+	while (ok) {
+		if (pending->length == pending->capacity && !chunk_grow(pending)) {
+			ok = 0;
+			break;
+		}
+		long long start = query_log_now_us();
+		ssize_t got = read(fd, pending->data + pending->length, pending->capacity - pending->length);
+		task->readMs += (query_log_now_us() - start) / 1000.0;
+		if (got < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ok = 0;
+			break;
+		}
+		if (got == 0) {
+			// EOF: hand over the final line if it had no newline
+			if (pending->length > 0 && queue_push(task->queue, pending)) {
+				pending = NULL;
+			}
+			break;
+		}
+		size_t scanFrom = pending->length;
+		pending->length += (size_t)got;
+		task->bytesRead += (size_t)got;
+		// The carried-over part has no newline, so only the new bytes need a scan
+		size_t end = pending->length;
+		while (end > scanFrom && pending->data[end - 1] != '\n') {
+			end--;
+		}
+		if (end == scanFrom) {
+			continue;
+		}
+		size_t tail = pending->length - end;
+		Chunk *next = chunk_create(tail > CHUNK_BYTES ? tail : CHUNK_BYTES);
+		if (next == NULL) {
+			ok = 0;
+			break;
+		}
+		memcpy(next->data, pending->data + end, tail);
+		next->length = tail;
+		pending->length = end;
+		if (!queue_push(task->queue, pending)) {
+			chunk_free(next);
+			break; // aborted downstream
+		}
+		pending = next;
+	}
+	close(fd);
+	chunk_free(pending);
+	if (!ok) {
+		abort_ingest(task->ctx);
+	}
+	queue_close(task->queue);
+	return NULL;
+}
+
+/*
+ * next_line
+ * 	NUL-terminate the line starting at *cursor inside 'chunk' and advance
+ * 	*cursor past it.
+ *
+ * Returns:
+ * 	The line, or NULL when the chunk is exhausted.
+ */
+static char *next_line(Chunk *chunk, size_t *cursor) {
+	if (*cursor >= chunk->length) {
+		return NULL;
+	}
+	char *line = chunk->data + *cursor;
+	char *newline = (char *)memchr(line, '\n', chunk->length - *cursor);
+	if (newline == NULL) {
+		chunk->data[chunk->length] = '\0';
+		*cursor = chunk->length;
+	} else {
+		*newline = '\0';
+		*cursor = (size_t)(newline - chunk->data) + 1;
+	}
+	return line;
+}
+
+static int is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+/*
+ * VertexNames
+ * 	Names collected by the vertex stage, back to back in one growable
+ * 	string table.
+ */
+typedef struct {
+	char *table;
+	size_t used;
+	size_t capacity;
+	size_t *offsets;
+	int count;
+	int offsetCapacity;
+} VertexNames;
+
+/*
+ * append_vertex_name
+ * 	Returns 1 on success, 0 on allocation failure.
+ */
+static int append_vertex_name(VertexNames *names, const char *name, size_t len) {
+	if (names->used + len + 1 > names->capacity) {
+		size_t newCapacity = names->capacity > 0 ? names->capacity : 4096;
+		while (names->used + len + 1 > newCapacity) {
+			newCapacity *= 2;
+		}
+		char *table = (char *)mem_realloc(MEM_SCRATCH, names->table, names->capacity, newCapacity);
+		if (table == NULL) {
+			return 0;
+		}
+		names->table = table;
+		names->capacity = newCapacity;
+	}
+	if (names->count == names->offsetCapacity) {
+		int newCapacity = names->offsetCapacity > 0 ? names->offsetCapacity * 2 : 256;
+		size_t *offsets = (size_t *)mem_realloc(MEM_SCRATCH, names->offsets,
+			(size_t)names->offsetCapacity * sizeof(size_t), (size_t)newCapacity * sizeof(size_t));
+		if (offsets == NULL) {
+			return 0;
+		}
+		names->offsets = offsets;
+		names->offsetCapacity = newCapacity;
+	}
+	memcpy(names->table + names->used, name, len);
+	names->table[names->used + len] = '\0';
+	names->offsets[names->count++] = names->used;
+	names->used += len + 1;
+	return 1;
+}
+
+/*
+ * vertex_main
+ * 	Collect one name per non-blank line (trailing CR/LF stripped, as in
+ * 	load_vertices), then create the graph and the name index the parsers
+ * 	resolve against, and publish both.
+ */
+static void *vertex_main(void *arg) {
+	IngestContext *ctx = (IngestContext *)arg;
+	VertexNames names;
+	memset(&names, 0, sizeof(names));
+	int ok = 1;
+	double busy = 0.0;
+	Chunk *chunk;
+	while ((chunk = queue_pop(&ctx->vertexChunks)) != NULL) {
+		long long start = query_log_now_us();
+		size_t cursor = 0;
+		char *line;
+		while (ok && (line = next_line(chunk, &cursor)) != NULL) {
+			size_t len = strlen(line);
+			while (len > 0 && line[len - 1] == '\r') {
+				len--;
+			}
+			const char *p = line;
+			while (p < line + len && is_space(*p)) {
+				p++;
+			}
+			if (p == line + len) {
+				continue; // blank line
+			}
+			ok = append_vertex_name(&names, line, len);
+		}
+		chunk_free(chunk);
+		busy += (query_log_now_us() - start) / 1000.0;
+	}
+
+	long long start = query_log_now_us();
+	Graph *graph = NULL;
+	NameIndex *index = NULL;
+	if (ok && names.count > 0) {
+		graph = create_graph(names.count);
+		for (int i = 0; graph != NULL && i < names.count; i++) {
+			set_vertex_name(graph, i, names.table + names.offsets[i]);
+		}
+		index = graph != NULL ? name_index_build(graph) : NULL;
+		if (index == NULL) {
+			free_graph(graph);
+			graph = NULL;
+		}
+	}
+	mem_free(MEM_SCRATCH, names.table, names.capacity);
+	mem_free(MEM_SCRATCH, names.offsets, (size_t)names.offsetCapacity * sizeof(size_t));
+	busy += (query_log_now_us() - start) / 1000.0;
+
+	if (graph == NULL) {
+		abort_ingest(ctx);
+	}
+	pthread_mutex_lock(&ctx->lock);
+	if (ctx->failed) {
+		// Aborted elsewhere (e.g. the distances file is missing): publish nothing
+		name_index_free(index);
+		free_graph(graph);
+	} else {
+		ctx->graph = graph;
+		ctx->names = index;
+	}
+	ctx->vertexMs = busy;
+	ctx->verticesDone = 1;
+	pthread_cond_broadcast(&ctx->verticesReady);
+	pthread_mutex_unlock(&ctx->lock);
+	return NULL;
+}
+
+/*
+ * wait_for_vertices
+ * 	Block until the vertex stage has published the name index.
+ *
+ * Returns:
+ * 	The index, or NULL if the load failed.
+ */
+static const NameIndex *wait_for_vertices(IngestContext *ctx) {
+	pthread_mutex_lock(&ctx->lock);
+	while (!ctx->verticesDone) {
+		pthread_cond_wait(&ctx->verticesReady, &ctx->lock);
+	}
+	const NameIndex *names = ctx->failed ? NULL : ctx->names;
+	pthread_mutex_unlock(&ctx->lock);
+	return names;
+}
+
+/*
+ * parse_chunk
+ * 	Tokenize every "<city1> <city2> <distance>" line of 'chunk' (same rules
+ * 	as load_distances), then wait for the name index and resolve the names.
+ * 	Lines are tokenized in place, so the chunk must outlive the call.
+ *
+ * Returns:
+ * 	Batch of resolved edges, or NULL if there are none or the load failed.
+ */
+static EdgeBatch *parse_chunk(ParserTask *task, Chunk *chunk) {
+	long long start = query_log_now_us();
+	int lines = 1;
+	for (const char *p = chunk->data; (p = memchr(p, '\n', chunk->length - (size_t)(p - chunk->data))) != NULL; p++) {
+		lines++;
+	}
+	EdgeBatch *batch = (EdgeBatch *)mem_calloc(MEM_SCRATCH, 1, sizeof(EdgeBatch));
+	const char **tokens = (const char **)mem_malloc(MEM_SCRATCH, (size_t)lines * 2 * sizeof(const char *));
+	if (batch != NULL) {
+		batch->triples = (int *)mem_malloc(MEM_SCRATCH, (size_t)lines * 3 * sizeof(int));
+		batch->capacity = batch->triples != NULL ? lines : 0;
+	}
+	if (batch == NULL || batch->triples == NULL || tokens == NULL) {
+		batch_free(batch);
+		mem_free(MEM_SCRATCH, tokens, (size_t)lines * 2 * sizeof(const char *));
+		abort_ingest(task->ctx);
+		return NULL;
+	}
+
+	// Tokenize; the weight of edge i waits in triples[3i + 2]
+	int parsed = 0;
+	size_t cursor = 0;
+	char *line;
+	while ((line = next_line(chunk, &cursor)) != NULL) {
+		char *p = line;
+		while (is_space(*p)) {
+			p++;
+		}
+		if (*p == '\0') {
+			continue; // blank line
+		}
+		char *city1 = p;
+		while (*p != '\0' && !is_space(*p)) {
+			p++;
+		}
+		if (*p == '\0') {
+			task->skippedLines++;
+			continue;
+		}
+		*p++ = '\0';
+		while (is_space(*p)) {
+			p++;
+		}
+		char *city2 = p;
+		while (*p != '\0' && !is_space(*p)) {
+			p++;
+		}
+		if (p == city2 || *p == '\0') {
+			task->skippedLines++;
+			continue;
+		}
+		*p++ = '\0';
+		char *end = NULL;
+		long weight = strtol(p, &end, 10);
+		if (end == p || weight > INT_MAX || weight < INT_MIN) {
+			task->skippedLines++;
+			continue;
+		}
+		tokens[2 * parsed] = city1;
+		tokens[2 * parsed + 1] = city2;
+		batch->triples[3 * parsed + 2] = (int)weight;
+		parsed++;
+	}
+	task->parseMs += (query_log_now_us() - start) / 1000.0;
+
+	const NameIndex *names = wait_for_vertices(task->ctx);
+	start = query_log_now_us();
+	int count = 0;
+	for (int i = 0; names != NULL && i < parsed; i++) {
+		int weight = batch->triples[3 * i + 2];
+		int u = name_index_find(names, tokens[2 * i]);
+		int v = name_index_find(names, tokens[2 * i + 1]);
+		if (u < 0 || v < 0) {
+			task->skippedLines++; // unknown city
+			continue;
+		}
+		batch->triples[3 * count] = u;
+		batch->triples[3 * count + 1] = v;
+		batch->triples[3 * count + 2] = weight;
+		count++;
+	}
+	batch->count = count;
+	mem_free(MEM_SCRATCH, tokens, (size_t)lines * 2 * sizeof(const char *));
+	task->parseMs += (query_log_now_us() - start) / 1000.0;
+	if (count == 0) {
+		batch_free(batch);
+		return NULL;
+	}
+	return batch;
+}
+
+/*
+ * parser_main
+ * 	Turn distance chunks into edge batches until the chunk queue closes.
+ */
+static void *parser_main(void *arg) {
+	ParserTask *task = (ParserTask *)arg;
+	Chunk *chunk;
+	while ((chunk = queue_pop(&task->ctx->distanceChunks)) != NULL) {
+		EdgeBatch *batch = parse_chunk(task, chunk);
+		chunk_free(chunk);
+		if (batch != NULL && !queue_push(&task->ctx->batches, batch)) {
+			batch_free(batch);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * builder_main
+ * 	The only stage that mutates the graph: insert every resolved edge.
+ */
+static void *builder_main(void *arg) {
+	IngestContext *ctx = (IngestContext *)arg;
+	Graph *graph = NULL;
+	double busy = 0.0;
+	double idle = 0.0;
+	long long edges = 0;
+	while (1) {
+		long long start = query_log_now_us();
+		EdgeBatch *batch = (EdgeBatch *)queue_pop(&ctx->batches);
+		idle += (query_log_now_us() - start) / 1000.0;
+		if (batch == NULL) {
+			break;
+		}
+		start = query_log_now_us();
+		if (graph == NULL) {
+			// Batches exist only after the vertex stage published the graph
+			pthread_mutex_lock(&ctx->lock);
+			graph = ctx->failed ? NULL : ctx->graph;
+			pthread_mutex_unlock(&ctx->lock);
+		}
+		for (int i = 0; graph != NULL && i < batch->count; i++) {
+			add_undirected_edge(graph, batch->triples[3 * i], batch->triples[3 * i + 1], batch->triples[3 * i + 2]);
+			edges++;
+		}
+		batch_free(batch);
+		busy += (query_log_now_us() - start) / 1000.0;
+	}
+	pthread_mutex_lock(&ctx->lock);
+	ctx->buildMs = busy;
+	ctx->builderIdleMs = idle;
+	ctx->edges = edges;
+	pthread_mutex_unlock(&ctx->lock);
+	return NULL;
+}
+
+/*
+ * ingest_graph
+ * 	Start every stage (consumers first), wait for the readers and parsers,
+ * 	close the batch queue, wait for the builder, and collect the graph and
+ * 	the name index the vertex stage built for it.
+ *
+ * Returns:
+ * 	1 on success, 0 on failure.
+ */
+int ingest_graph(const char *verticesFilePath, const char *distancesFilePath, int parserThreads, Graph **outGraph, NameIndex **outNames, IngestStats *outStats) {
+	if (verticesFilePath == NULL || distancesFilePath == NULL || outGraph == NULL) {
+		return 0;
+	}
+	*outGraph = NULL;
+	if (outNames != NULL) {
+		*outNames = NULL;
+	}
+	if (parserThreads < 1) {
+		parserThreads = 1;
+	} else if (parserThreads > INGEST_MAX_PARSERS) {
+		parserThreads = INGEST_MAX_PARSERS;
+	}
+	long long start = query_log_now_us();
+
+	IngestContext ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	if (!queue_init(&ctx.vertexChunks, CHUNK_QUEUE_DEPTH)) {
+		return 0;
+	}
+	if (!queue_init(&ctx.distanceChunks, CHUNK_QUEUE_DEPTH)) {
+		queue_destroy(&ctx.vertexChunks);
+		return 0;
+	}
+	if (!queue_init(&ctx.batches, BATCH_QUEUE_DEPTH)) {
+		queue_destroy(&ctx.distanceChunks);
+		queue_destroy(&ctx.vertexChunks);
+		return 0;
+	}
+	pthread_mutex_init(&ctx.lock, NULL);
+	pthread_cond_init(&ctx.verticesReady, NULL);
+
+	ReaderTask readers[2] = {
+		{ &ctx, verticesFilePath, &ctx.vertexChunks, 0.0, 0 },
+		{ &ctx, distancesFilePath, &ctx.distanceChunks, 0.0, 0 }
+	};
+	ParserTask parsers[INGEST_MAX_PARSERS];
+	pthread_t builderHandle;
+	pthread_t vertexHandle;
+	pthread_t parserHandles[INGEST_MAX_PARSERS];
+	pthread_t readerHandles[2];
+	int builderStarted = pthread_create(&builderHandle, NULL, builder_main, &ctx) == 0;
+	int vertexStarted = pthread_create(&vertexHandle, NULL, vertex_main, &ctx) == 0;
+	int parsersStarted = 0;
+	for (int i = 0; i < parserThreads; i++) {
+		parsers[i].ctx = &ctx;
+		parsers[i].parseMs = 0.0;
+		parsers[i].skippedLines = 0;
+		if (pthread_create(&parserHandles[i], NULL, parser_main, &parsers[i]) != 0) {
+			break;
+		}
+		parsersStarted++;
+	}
+	int readersStarted = 0;
+	for (int i = 0; i < 2; i++) {
+		if (pthread_create(&readerHandles[i], NULL, reader_main, &readers[i]) != 0) {
+			break;
+		}
+		readersStarted++;
+	}
+	if (!builderStarted || !vertexStarted || parsersStarted == 0 || readersStarted < 2) {
+		abort_ingest(&ctx);
+	}
+
+	for (int i = 0; i < readersStarted; i++) {
+		pthread_join(readerHandles[i], NULL);
+	}
+	for (int i = 0; i < parsersStarted; i++) {
+		pthread_join(parserHandles[i], NULL);
+	}
+	queue_close(&ctx.batches);
+	if (builderStarted) {
+		pthread_join(builderHandle, NULL);
+	}
+	if (vertexStarted) {
+		pthread_join(vertexHandle, NULL);
+	}
+
+	// Stages that never started leave items behind
+	Chunk *chunk;
+	while ((chunk = queue_pop(&ctx.vertexChunks)) != NULL) {
+		chunk_free(chunk);
+	}
+	while ((chunk = queue_pop(&ctx.distanceChunks)) != NULL) {
+		chunk_free(chunk);
+	}
+	EdgeBatch *batch;
+	while ((batch = queue_pop(&ctx.batches)) != NULL) {
+		batch_free(batch);
+	}
+
+	int ok = !ctx.failed && ctx.graph != NULL;
+	if (!ok) {
+		name_index_free(ctx.names);
+		free_graph(ctx.graph);
+	} else {
+		*outGraph = ctx.graph;
+		if (outNames != NULL) {
+			*outNames = ctx.names;
+		} else {
+			name_index_free(ctx.names);
+		}
+	}
+	if (outStats != NULL) {
+		memset(outStats, 0, sizeof(*outStats));
+		outStats->readMs = readers[0].readMs + readers[1].readMs;
+		outStats->vertexMs = ctx.vertexMs;
+		for (int i = 0; i < parsersStarted; i++) {
+			outStats->parseMs += parsers[i].parseMs;
+			outStats->skippedLines += parsers[i].skippedLines;
+		}
+		outStats->buildMs = ctx.buildMs;
+		outStats->builderIdleMs = ctx.builderIdleMs;
+		outStats->totalMs = (query_log_now_us() - start) / 1000.0;
+		outStats->bytesRead = readers[0].bytesRead + readers[1].bytesRead;
+		outStats->parserThreads = parsersStarted;
+		outStats->vertices = ok ? ctx.graph->numVertices : 0;
+		outStats->edges = ctx.edges;
+	}
+
+	pthread_cond_destroy(&ctx.verticesReady);
+	pthread_mutex_destroy(&ctx.lock);
+	queue_destroy(&ctx.batches);
+	queue_destroy(&ctx.distanceChunks);
+	queue_destroy(&ctx.vertexChunks);
+	return ok;
+}
+
+/*
+ * ingest_report
+ * 	One line: sizes, wall time, then busy time per stage.
+ */
+void ingest_report(const IngestStats *stats, FILE *out) {
+	if (stats == NULL || out == NULL) {
+		return;
+	}
+	fprintf(out, "Ingest: %d cities, %lld edges (%lld lines skipped) from %.1f KiB in %.1f ms;"
+		" read %.1f, vertices %.1f, parse %.1f on %d threads, build %.1f, builder idle %.1f ms\n",
+		stats->vertices, stats->edges, stats->skippedLines, (double)stats->bytesRead / 1024.0, stats->totalMs,
+		stats->readMs, stats->vertexMs, stats->parseMs, stats->parserThreads, stats->buildMs, stats->builderIdleMs);
+}
@@ -0,0 +1,49 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "graph.h"
+#include "nameindex.h"
+
+// Distance parser threads used when the caller has no preference.
+#define INGEST_DEFAULT_PARSERS 2
+// Upper bound on distance parser threads.
+#define INGEST_MAX_PARSERS 16
+
+// Where the time went during one pipelined load. Stage times are busy time
+// (not time spent blocked on a queue); parseMs is summed over all parser
+// threads, so it can exceed totalMs.
+typedef struct {
+	double readMs;           // inside read() for both files
+	double vertexMs;         // splitting vertex lines, naming vertices, indexing names
+	double parseMs;          // tokenizing distance lines and resolving city names
+	double buildMs;          // inserting edges into the graph
+	double builderIdleMs;    // builder blocked waiting for parsed edges
+	double totalMs;          // wall time of the whole load
+	size_t bytesRead;
+	int parserThreads;
+	int vertices;
+	long long edges;         // undirected edges added (before compaction)
+	long long skippedLines;  // malformed lines and edges with unknown cities
+} IngestStats;
+
+// ingest_graph:
+//   Loads the vertices and distances files concurrently through a staged
+//   pipeline: one reader per file doing large sequential reads, a vertex
+//   stage, 'parserThreads' distance parsers and one graph builder, joined by
+//   bounded queues. Accepts the same formats as load_vertices and
+//   load_distances; malformed lines and unknown cities are skipped.
+//   The name index the parsers resolved against goes to *outNames so it need
+//   not be sorted again; outNames and outStats may be NULL.
+// Returns:
+//   1 on success with the graph in *outGraph (caller frees with free_graph)
+//   and its index in *outNames (caller frees with name_index_free),
+//   0 on failure (nothing is allocated on failure).
+int ingest_graph(const char *verticesFilePath, const char *distancesFilePath, int parserThreads, Graph **outGraph, NameIndex **outNames, IngestStats *outStats);
+
+// Prints a one-line summary of 'stats'.
+void ingest_report(const IngestStats *stats, FILE *out);
+
+#endif
@@ -1,4 +1,6 @@
 #include "io.h"
+
+#include "ingest.h"
 /*
  * I/O helpers
  *
@@ -138,6 +140,94 @@ int load_distances(Graph *graph, const char *distancesFilePath) {
 	return 1;
 }
 
+/* 
+ * load_graph
+ * 	Load both files through the pipelined ingest (or sequentially for
+ * 	parserThreads 0), then run compact_edges. The sequential path builds
+ * 	the name index itself; the ingest hands over the one it resolved with.
+ *
+ * Returns:
+ * 	1 on success, 0 on failure.
+ * 	Caller owns the returned Graph* and NameIndex*.
+ */
+int load_graph(const char *verticesFilePath, const char *distancesFilePath, int parserThreads, Graph **outGraph, NameIndex **outNames, EdgeCompaction *outCompaction) {
+	if (outGraph == NULL) {
+		return 0;
+	}
+	*outGraph = NULL;
+	if (outNames != NULL) {
+		*outNames = NULL;
+	}
+	Graph *graph = NULL;
+	NameIndex *names = NULL;
+	if (parserThreads > 0) {
+		if (!ingest_graph(verticesFilePath, distancesFilePath, parserThreads, &graph, outNames != NULL ? &names : NULL, NULL)) {
+			return 0;
+		}
+	} else {
+		if (!load_vertices(verticesFilePath, &graph) || graph == NULL) {
+			return 0;
+		}
+		if (!load_distances(graph, distancesFilePath)) {
+			free_graph(graph);
+			return 0;
+		}
+		if (outNames != NULL) {
+			names = name_index_build(graph);
+			if (names == NULL) {
+				free_graph(graph);
+				return 0;
+			}
+		}
+	}
+	compact_edges(graph, outCompaction);
+	*outGraph = graph;
+	if (outNames != NULL) {
+		*outNames = names;
+	}
+	return 1;
+}
+
+/* 
+ * line_writer_init
+ * 	Start an empty buffer writing to 'out'.
+ */
+void line_writer_init(LineWriter *writer, FILE *out) {
+	writer->out = out;
+	writer->used = 0;
+}
+
+/* 
+ * line_writer_put
+ * 	Copy 'line' and a newline into the buffer, flushing first when it
+ * 	would not fit.
+ */
+void line_writer_put(LineWriter *writer, const char *line) {
+	size_t len = strlen(line);
+	if (writer->used + len + 1 > sizeof(writer->buffer)) {
+		line_writer_flush(writer);
+	}
+	if (len + 1 > sizeof(writer->buffer)) {
+		fwrite(line, 1, len, writer->out);
+		fputc('\n', writer->out);
+		return;
+	}
+	memcpy(writer->buffer + writer->used, line, len);
+	writer->used += len;
+	writer->buffer[writer->used++] = '\n';
+}
+
+/* 
+ * line_writer_flush
+ * 	Hand the buffered lines to fwrite and empty the buffer.
+ */
+void line_writer_flush(LineWriter *writer) {
+	if (writer->used > 0) {
+		fwrite(writer->buffer, 1, writer->used, writer->out);
+		writer->used = 0;
+	}
+}
+
 /* 
  * print_help
  * 	Display available commands for the interactive program.
@@ -145,7 +235,12 @@ int load_distances(Graph *graph, const char *distancesFilePath) {
 void print_help(void) {
 	printf("Commands:\n");
 	printf("\tlist - list all cities\n");
+	printf("\tlist <prefix> [page] - list cities starting with a prefix, one page at a time\n");
 	printf("\t<city1> <city2> - find the shortest path between two cities\n");
+	printf("\tdistance <city1> <city2> - print only the shortest distance\n");
+	printf("\twithin <city> <distance> - list cities reachable within a distance\n");
+	printf("\treload <vertices> <distances> - load new graph files in the background\n");
+	printf("\tmem - show memory use by subsystem\n");
 	printf("\thelp - print this help message\n");
 	printf("\texit - exit the program\n");
 }
@@ -2,6 +2,7 @@
 #define IO_H
 
 #include "graph.h"
+#include "nameindex.h"
 
 // load_vertices:
 //   Loads vertex names from the given file (one per line).
@@ -15,6 +16,37 @@ int load_vertices(const char *verticesFilePath, Graph **outGraph);
 //   Returns 1 on success, 0 on failure.
 int load_distances(Graph *graph, const char *distancesFilePath);
 
+// load_graph:
+//   Loads vertex names and distances into a new Graph with the pipelined
+//   ingest on 'parserThreads' parsers (see ingest_graph), or with
+//   load_vertices and load_distances when it is 0, and compacts its edges
+//   (see compact_edges); what was removed goes to outCompaction.
+//   On success, stores the graph in outGraph (caller frees with free_graph)
+//   and its name index in outNames (caller frees with name_index_free).
+//   outNames and outCompaction may be NULL.
+//   Returns 1 on success, 0 on failure (nothing is allocated on failure).
+int load_graph(const char *verticesFilePath, const char *distancesFilePath, int parserThreads, Graph **outGraph, NameIndex **outNames, EdgeCompaction *outCompaction);
+
+// Buffered line output shared by the listing commands: lines are gathered
+// into one buffer and handed to fwrite in large chunks instead of one
+// formatted write per line.
+#define LINE_WRITER_BUFFER_SIZE 65536
+
+typedef struct {
+	FILE *out;
+	size_t used;
+	char buffer[LINE_WRITER_BUFFER_SIZE];
+} LineWriter;
+
+void line_writer_init(LineWriter *writer, FILE *out);
+
+// Appends 'line' followed by a newline. A line longer than the buffer is
+// written directly after flushing what precedes it.
+void line_writer_put(LineWriter *writer, const char *line);
+
+// Writes out whatever is buffered.
+void line_writer_flush(LineWriter *writer);
+
 // print_help:
 //   Prints the interactive help text as specified by the assignment.
 void print_help(void);
@@ -2,21 +2,79 @@
  * City Finder - interactive shortest-path CLI
  *
  * Reads a list of city names and undirected distances, then provides a small
- * REPL to list cities and compute the shortest path between two given cities
- * using Dijkstra's algorithm.
+ * REPL to list cities, compute the shortest path between two given cities
+ * using Dijkstra's algorithm, and list every city within a distance budget.
+ * The graph can be reloaded from new files (via the `reload` command or
+ * SIGHUP) while queries keep running against the previous one.
  *
  * Usage:
- *   ./city-finder <vertices> <distances>
+ *   ./city-finder [--query-log=<file>] [--engine=<name>|auto]
+ *                 [--expected-queries=<n>] [--label-mem-cap=<MiB>]
+ *                 [--mem-budget=<subsystem>=<bytes>]... [--ingest-threads=<n>]
+ *                 [--self-check[=<n>]] <vertices> <distances>
  *
  * This file contains the program entry-point and small UI helpers.
  */
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdint.h>
 
 #include "graph.h"
 #include "io.h"
 #include "dijkstra.h"
+#include "search.h"
+#include "querylog.h"
+#include "graphstore.h"
+#include "engine.h"
+#include "nameindex.h"
+#include "memstat.h"
+#include "ingest.h"
+
+// Names per page for "list <prefix> [page]".
+#define LIST_PAGE_SIZE 50
+// Did-you-mean candidates shown for an unknown city.
+#define MAX_SUGGESTIONS 5
+// Random queries per engine for a bare --self-check.
+#define DEFAULT_SELF_CHECK_QUERIES 200
+// Query volume assumed by --engine=auto when --expected-queries is not given.
+#define DEFAULT_EXPECTED_QUERIES 1000
+
+// Set by the SIGHUP handler; the REPL starts a reload of the last files.
+static volatile sig_atomic_t reloadRequested = 0;
+
+/*
+ * Session
+ * 	State shared by the REPL command handlers: the graph store and the
+ * 	version bound for the current command, scratch memory reused across
+ * 	queries, and the optional query log.
+ */
+typedef struct {
+	GraphStore *store;
+	int readerSlot;
+	const GraphVersion *version; // version entered for this command
+	Graph *graph;                // version->graph
+	unsigned long generation;    // generation the workspace was built for
+	SearchWorkspace *ws;
+	QueryLog *log;               // NULL when query logging is disabled
+	char verticesFile[512];      // files of the last successful (re)load, for SIGHUP
+	char distancesFile[512];
+	char pendingVerticesFile[512];   // files of the reload in progress
+	char pendingDistancesFile[512];
+} Session;
+
+/* 
+ * handle_sighup
+ * 	Signal handler: request a reload of the last loaded files.
+ */
+static void handle_sighup(int signum) {
+	(void)signum;
+	reloadRequested = 1;
+}
 
 /* 
  * print_welcome
@@ -39,34 +97,168 @@ static void prompt(void) {
 	fflush(stdout);
 }
 
+/* 
+ * log_query
+ * 	Append one record to the session's query log, if logging is enabled.
+ *
+ * Parameters:
+ * 	- session: current REPL session
+ * 	- command: "path", "distance", "within", "list" or "prefix"
+ * 	- src, dst, budget: resolved query arguments (-1 when not applicable;
+ * 	  budget holds the page number for "prefix")
+ * 	- prefix: name prefix for "prefix", NULL otherwise
+ * 	- startWallMs, startUs: wall and monotonic time the query started
+ * 	- resultSize: number of cities in the answer
+ */
+static void log_query(const Session *session, const char *command, int src, int dst, int budget, const char *prefix, long long startWallMs, long long startUs, int resultSize) {
+	if (session->log == NULL) {
+		return;
+	}
+	QueryLogRecord record;
+	memset(&record, 0, sizeof(record));
+	record.timestampMs = startWallMs;
+	strncpy(record.command, command, sizeof(record.command) - 1);
+	record.src = src;
+	record.dst = dst;
+	record.budget = budget;
+	if (prefix != NULL) {
+		strncpy(record.prefix, prefix, sizeof(record.prefix) - 1);
+	}
+	record.latencyUs = query_log_now_us() - startUs;
+	record.resultSize = resultSize;
+	query_log_write(session->log, &record);
+}
+
+/* 
+ * handle_list
+ * 	Print every city name and log the query.
+ */
+static void handle_list(const Session *session) {
+	long long startWallMs = query_log_wall_ms();
+	long long startUs = query_log_now_us();
+	list_cities(session->graph);
+	log_query(session, "list", -1, -1, -1, NULL, startWallMs, startUs, session->graph->numVertices);
+}
+
+/* 
+ * handle_list_prefix
+ * 	Print one page of the cities whose names start with 'prefix', in
+ * 	alphabetical order, using the sorted name index.
+ *
+ * Parameters:
+ * 	- session: current REPL session
+ * 	- prefix: name prefix to match
+ * 	- pageText: 1-based page number as typed, or NULL for the first page
+ *
+ * Behavior:
+ * 	- Prints "Invalid Command" and help for a page that is not a positive
+ * 	  integer.
+ * 	- Prints a footer naming the next page when more matches remain.
+ * 	- Logs the query as "prefix" with the prefix and page, timed over the
+ * 	  whole listing like handle_list.
+ */
+static void handle_list_prefix(const Session *session, const char *prefix, const char *pageText) {
+	long page = 1;
+	if (pageText != NULL) {
+		char *end = NULL;
+		page = strtol(pageText, &end, 10);
+		if (end == pageText || *end != '\0' || page < 1 || page > INT_MAX) {
+			printf("Invalid Command\n");
+			print_help();
+			return;
+		}
+	}
+	long long startWallMs = query_log_wall_ms();
+	long long startUs = query_log_now_us();
+	const NameIndex *names = session->version->names;
+	int first = 0;
+	int matches = name_index_prefix_range(names, prefix, &first);
+	long pages = (matches + LIST_PAGE_SIZE - 1) / LIST_PAGE_SIZE;
+	if (matches == 0) {
+		printf("No Cities Match \"%s\"...\n", prefix);
+	} else if (page > pages) {
+		printf("Page %ld is past the last page (%ld)\n", page, pages);
+	} else {
+		int start = (int)((page - 1) * LIST_PAGE_SIZE);
+		int count = matches - start < LIST_PAGE_SIZE ? matches - start : LIST_PAGE_SIZE;
+		printf("Cities Matching \"%s\" (%d-%d of %d):\n", prefix, start + 1, start + count, matches);
+		fflush(stdout);
+		name_index_write(names, first + start, count, stdout);
+		if (page < pages) {
+			printf("Page %ld of %ld; type \"list %s %ld\" for more\n", page, pages, prefix, page + 1);
+		}
+	}
+	log_query(session, "prefix", -1, -1, (int)page, prefix, startWallMs, startUs, matches);
+}
+
+/* 
+ * resolve_city
+ * 	Look up a city through the sorted name index. When the name is unknown,
+ * 	print it together with did-you-mean suggestions.
+ *
+ * Returns:
+ * 	Vertex index, or -1 if the city does not exist.
+ */
+static int resolve_city(const Session *session, const char *name) {
+	const NameIndex *names = session->version->names;
+	int index = name_index_find(names, name);
+	if (index >= 0) {
+		return index;
+	}
+	int suggestions[MAX_SUGGESTIONS];
+	int count = name_index_suggest(names, name, suggestions, MAX_SUGGESTIONS);
+	if (count == 0) {
+		printf("Unknown city \"%s\"\n", name);
+		return -1;
+	}
+	printf("Unknown city \"%s\". Did you mean:", name);
+	for (int i = 0; i < count; i++) {
+		printf("%s %s", i > 0 ? "," : "", session->graph->vertexNames[suggestions[i]]);
+	}
+	printf("?\n");
+	return -1;
+}
+
 /* 
  * handle_two_cities
- * 	Resolve city names to vertex indices, run Dijkstra from src to dst,
- * 	and print either the resulting path and total distance or an error.
+ * 	Resolve city names to vertex indices, run the version's routing engine
+ * 	from src to dst, and print either the resulting path and total distance
+ * 	or an error.
  *
  * Parameters:
- * 	- graph: loaded graph of cities and distances (must be non-NULL)
+ * 	- session: current REPL session (graph must be non-NULL)
  * 	- city1, city2: null-terminated city names to connect
  *
  * Behavior:
  * 	- On success, prints the path in order and its total distance.
- * 	- On failure or unknown city, prints "Invalid Command" and help or
- * 	  "Path Not Found..." as appropriate.
- * 	- Frees any path buffer allocated by dijkstra_shortest_path.
+ * 	- For an unknown city, prints it with did-you-mean suggestions.
+ * 	- Routes the int engines report as DIJKSTRA_TOO_LONG are retried
+ * 	  with the 64-bit search; plain misses are not.
+ * 	- Prints "Path Not Found..." when no path exists.
+ * 	- Frees any path buffer allocated by the engine.
  */
-static void handle_two_cities(Graph *graph, const char *city1, const char *city2) {
-	int src = find_vertex_index(graph, city1);
-	int dst = find_vertex_index(graph, city2);
+static void handle_two_cities(const Session *session, const char *city1, const char *city2) {
+	Graph *graph = session->graph;
+	int src = resolve_city(session, city1);
+	int dst = resolve_city(session, city2);
 	if (src < 0 || dst < 0) {
-		printf("Invalid Command\n");
-		print_help();
 		return;
 	}
 
 	int *path = NULL;
 	int pathLen = 0;
 	int total = 0;
-	int found = dijkstra_shortest_path(graph, src, dst, &path, &pathLen, &total);
+	long long wideTotal = 0;
+	long long startWallMs = query_log_wall_ms();
+	long long startUs = query_log_now_us();
+	const RoutingEngine *engine = session->version->engine;
+	int found = engine->query(session->version->engineState, graph, src, dst, &path, &pathLen, &total);
+	if (found > 0) {
+		wideTotal = total;
+	} else if (found == DIJKSTRA_TOO_LONG) {
+		found = dijkstra_shortest_path_wide(graph, src, dst, &path, &pathLen, &wideTotal);
+	}
+	log_query(session, "path", src, dst, -1, NULL, startWallMs, startUs, found > 0 ? pathLen : 0);
 	if (found <= 0) {
 		printf("Path Not Found...\n");
 		free(path);
@@ -78,46 +270,446 @@ static void handle_two_cities(Graph *graph, const char *city1, const char *city2
 		int idx = path[i];
 		printf("\t%s\n", graph->vertexNames[idx]);
 	}
-	printf("Total Distance: %d\n", total);
+	printf("Total Distance: %lld\n", wideTotal);
 	free(path);
 }
 
+/* 
+ * handle_distance
+ * 	Resolve city names and print only the shortest distance between them,
+ * 	through the engine's distance lookup so no path is built.
+ *
+ * Behavior:
+ * 	- For an unknown city, prints it with did-you-mean suggestions.
+ * 	- Distances the int engines report as DIJKSTRA_TOO_LONG are retried
+ * 	  with the 64-bit search.
+ * 	- Prints "Path Not Found..." when no path exists.
+ */
+static void handle_distance(const Session *session, const char *city1, const char *city2) {
+	Graph *graph = session->graph;
+	int src = resolve_city(session, city1);
+	int dst = resolve_city(session, city2);
+	if (src < 0 || dst < 0) {
+		return;
+	}
+
+	int total = 0;
+	long long wideTotal = 0;
+	long long startWallMs = query_log_wall_ms();
+	long long startUs = query_log_now_us();
+	int found = engine_distance(session->version->engine, session->version->engineState, graph, src, dst, &total);
+	if (found > 0) {
+		wideTotal = total;
+	} else if (found == DIJKSTRA_TOO_LONG) {
+		found = dijkstra_distance_wide(graph, src, dst, &wideTotal);
+	}
+	log_query(session, "distance", src, dst, -1, NULL, startWallMs, startUs, found > 0 ? 1 : 0);
+	if (found <= 0) {
+		printf("Path Not Found...\n");
+		return;
+	}
+	printf("Total Distance: %lld\n", wideTotal);
+}
+
+/* 
+ * handle_within
+ * 	Resolve the origin city, parse the distance budget, and print every
+ * 	city reachable within that budget, nearest first.
+ *
+ * Parameters:
+ * 	- session: current REPL session (graph and workspace must be non-NULL)
+ * 	- city: origin city name
+ * 	- budgetText: distance budget as typed by the user
+ *
+ * Behavior:
+ * 	- For an unknown city, prints it with did-you-mean suggestions.
+ * 	- Prints "Invalid Command" and help for a budget that is not a
+ * 	  non-negative integer.
+ * 	- Prints "No Cities Within Range..." when nothing else is reachable.
+ */
+static void handle_within(const Session *session, const char *city, const char *budgetText) {
+	Graph *graph = session->graph;
+	char *end = NULL;
+	long budget = strtol(budgetText, &end, 10);
+	if (end == budgetText || *end != '\0' || budget < 0 || budget >= INF_DISTANCE) {
+		printf("Invalid Command\n");
+		print_help();
+		return;
+	}
+	int src = resolve_city(session, city);
+	if (src < 0) {
+		return;
+	}
+
+	RangeResult *results = NULL;
+	int count = 0;
+	long long startWallMs = query_log_wall_ms();
+	long long startUs = query_log_now_us();
+	int status = search_within(session->ws, src, (int)budget, &results, &count);
+	log_query(session, "within", src, -1, (int)budget, NULL, startWallMs, startUs, status > 0 ? count : 0);
+	if (status < 0) {
+		printf("Search Failed...\n");
+		return;
+	}
+	if (count == 0) {
+		printf("No Cities Within Range...\n");
+		free(results);
+		return;
+	}
+	printf("Cities Within Range...\n");
+	for (int i = 0; i < count; i++) {
+		printf("\t%s %d\n", graph->vertexNames[results[i].vertex], results[i].distance);
+	}
+	free(results);
+}
+
+/* 
+ * bind_version
+ * 	Point the session at 'version' for the current command, building a
+ * 	search workspace for its graph if the session has none (see
+ * 	release_stale_workspace).
+ *
+ * Returns:
+ * 	1 on success, 0 if the workspace could not be allocated.
+ */
+static int bind_version(Session *session, const GraphVersion *version) {
+	session->version = version;
+	session->graph = version->graph;
+	if (session->ws != NULL && session->generation == version->generation) {
+		return 1;
+	}
+	search_workspace_free(session->ws);
+	session->ws = search_workspace_create(version->graph, MEM_SCRATCH);
+	session->generation = version->generation;
+	return session->ws != NULL;
+}
+
+/* 
+ * release_stale_workspace
+ * 	Called before leaving a command, while its version is still pinned:
+ * 	if a reload has already replaced that version, free the workspace now,
+ * 	before the old graph can be reclaimed. A reload that lands between
+ * 	commands leaves a workspace that is never used again; bind_version
+ * 	frees it without touching the graph.
+ */
+static void release_stale_workspace(Session *session) {
+	if (session->ws != NULL && graph_store_generation(session->store) != session->generation) {
+		search_workspace_free(session->ws);
+		session->ws = NULL;
+	}
+}
+
+/* 
+ * start_reload
+ * 	Begin a background reload from the given files. They become the target
+ * 	of future SIGHUP reloads only once the reload succeeds (see
+ * 	report_reload), so a bad path is never retried.
+ */
+static void start_reload(Session *session, const char *verticesFile, const char *distancesFile) {
+	int status = graph_store_reload_async(session->store, verticesFile, distancesFile);
+	if (status == 0) {
+		printf("Reload already in progress...\n");
+		return;
+	}
+	if (status < 0) {
+		printf("Reload could not be started\n");
+		return;
+	}
+	printf("Reloading graph from %s and %s...\n", verticesFile, distancesFile);
+	snprintf(session->pendingVerticesFile, sizeof(session->pendingVerticesFile), "%s", verticesFile);
+	snprintf(session->pendingDistancesFile, sizeof(session->pendingDistancesFile), "%s", distancesFile);
+}
+
+/* 
+ * handle_mem
+ * 	Print memory use per subsystem for the bound graph.
+ */
+static void handle_mem(const Session *session) {
+	mem_report(session->graph->numVertices, session->graph->numEdges, 1, stdout);
+}
+
+/* 
+ * parse_mem_budget
+ * 	Parse "<subsystem>=<bytes>" where bytes may end in K, M or G, and set
+ * 	that subsystem's budget.
+ *
+ * Returns:
+ * 	1 on success, 0 on an unknown subsystem, a malformed size or one that
+ * 	does not fit in size_t.
+ */
+static int parse_mem_budget(const char *spec) {
+	const char *equals = strchr(spec, '=');
+	if (equals == NULL || equals == spec || (size_t)(equals - spec) >= 32) {
+		return 0;
+	}
+	char name[32];
+	memcpy(name, spec, (size_t)(equals - spec));
+	name[equals - spec] = '\0';
+	int subsystem = mem_subsystem_from_name(name);
+	if (subsystem < 0) {
+		return 0;
+	}
+	const char *digits = equals + 1;
+	if (*digits < '0' || *digits > '9') {
+		return 0; // strtoull would accept a sign or leading blanks
+	}
+	char *end = NULL;
+	errno = 0;
+	unsigned long long value = strtoull(digits, &end, 10);
+	if (errno == ERANGE) {
+		return 0;
+	}
+	int shift = 0;
+	if (*end == 'K' || *end == 'k') {
+		shift = 10;
+		end++;
+	} else if (*end == 'M' || *end == 'm') {
+		shift = 20;
+		end++;
+	} else if (*end == 'G' || *end == 'g') {
+		shift = 30;
+		end++;
+	}
+	if (*end != '\0' || value > (unsigned long long)(SIZE_MAX >> shift)) {
+		return 0;
+	}
+	mem_set_budget((MemSubsystem)subsystem, (size_t)value << shift);
+	return 1;
+}
+
+/* 
+ * parse_label_mem_cap
+ * 	Parse the --label-mem-cap value, a whole number of MiB, and set the
+ * 	index memory cap.
+ *
+ * Returns:
+ * 	1 on success, 0 on a malformed or negative value or one whose size in
+ * 	bytes does not fit in size_t.
+ */
+static int parse_label_mem_cap(const char *text) {
+	char *end = NULL;
+	errno = 0;
+	long mib = strtol(text, &end, 10);
+	if (end == text || *end != '\0' || errno == ERANGE || mib < 0 || (unsigned long)mib > (SIZE_MAX >> 20)) {
+		return 0;
+	}
+	engine_set_index_memory_cap((size_t)mib << 20);
+	return 1;
+}
+
+/* 
+ * report_engine
+ * 	Print the engine's preprocessing figures, if it has any.
+ */
+static void report_engine(const GraphVersion *version) {
+	if (version->engine->report != NULL) {
+		version->engine->report(version->engineState, stdout);
+	}
+}
+
+/* 
+ * report_compaction
+ * 	Print what edge compaction removed, if anything.
+ */
+static void report_compaction(const EdgeCompaction *compaction) {
+	if (compaction->duplicates + compaction->parallel + compaction->selfLoops == 0) {
+		return;
+	}
+	printf("Edge compaction removed %d duplicate, %d parallel and %d self-loop edges\n",
+		compaction->duplicates, compaction->parallel, compaction->selfLoops);
+}
+
+/* 
+ * report_reload
+ * 	Print the outcome of a finished background reload, if there is one.
+ * 	A successful reload's files become the target of later SIGHUPs.
+ */
+static void report_reload(Session *session) {
+	ReloadResult result = graph_store_take_reload_result(session->store);
+	if (result == RELOAD_SUCCEEDED) {
+		memcpy(session->verticesFile, session->pendingVerticesFile, sizeof(session->verticesFile));
+		memcpy(session->distancesFile, session->pendingDistancesFile, sizeof(session->distancesFile));
+		const GraphVersion *version = graph_store_enter(session->store, session->readerSlot);
+		printf("Graph reloaded (generation %lu, %d cities)\n", version->generation, version->graph->numVertices);
+		report_compaction(&version->compaction);
+		report_engine(version);
+		graph_store_exit(session->store, session->readerSlot);
+	} else if (result == RELOAD_FAILED) {
+		printf("Reload failed; still using the previous graph\n");
+	}
+}
+
 /* 
  * main
  * 	Top-level program flow:
- * 	 - parse CLI arguments (expects vertices and distances files),
- * 	 - load the graph,
- * 	 - enter a small command loop to list cities, show help, compute paths,
+ * 	 - parse CLI arguments (expects vertices and distances files, plus
+ * 	   optional --query-log, --engine, --expected-queries, --label-mem-cap,
+ * 	   --mem-budget, --ingest-threads and --self-check),
+ * 	 - load the graph (pipelined unless --ingest-threads=0) and compact it,
+ * 	 - enter a small command loop to list cities, show help, compute paths
+ * 	   and range queries, and reload the graph in the background,
  * 	 - clean up and exit.
+ * 	With --self-check the REPL is skipped: every engine is cross-validated
+ * 	against the reference and the exit status reports the result.
  *
  * Returns:
- * 	0 on normal termination; non-zero on usage or loading errors.
+ * 	0 on normal termination; non-zero on usage or loading errors or a
+ * 	failed self-check.
  */
 int main(int argc, char **argv) {
-	if (argc != 3) {
-		fprintf(stderr, "Usage: %s <vertices> <distances>\n", argv[0]);
+	const char *verticesFile = NULL;
+	const char *distancesFile = NULL;
+	const char *queryLogFile = NULL;
+	const char *engineName = "dijkstra";
+	long expectedQueries = DEFAULT_EXPECTED_QUERIES;
+	int selfCheckQueries = 0;
+	int ingestThreads = INGEST_DEFAULT_PARSERS;
+	int positional = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--query-log=", 12) == 0) {
+			queryLogFile = argv[i] + 12;
+		} else if (strncmp(argv[i], "--engine=", 9) == 0) {
+			engineName = argv[i] + 9;
+		} else if (strncmp(argv[i], "--expected-queries=", 19) == 0) {
+			expectedQueries = atol(argv[i] + 19);
+		} else if (strncmp(argv[i], "--label-mem-cap=", 16) == 0) {
+			if (!parse_label_mem_cap(argv[i] + 16)) {
+				positional = -1; // malformed cap
+				break;
+			}
+		} else if (strncmp(argv[i], "--mem-budget=", 13) == 0) {
+			if (!parse_mem_budget(argv[i] + 13)) {
+				positional = -1; // malformed budget
+				break;
+			}
+		} else if (strncmp(argv[i], "--ingest-threads=", 17) == 0) {
+			ingestThreads = atoi(argv[i] + 17);
+		} else if (strcmp(argv[i], "--self-check") == 0) {
+			selfCheckQueries = DEFAULT_SELF_CHECK_QUERIES;
+		} else if (strncmp(argv[i], "--self-check=", 13) == 0) {
+			selfCheckQueries = atoi(argv[i] + 13);
+		} else if (strncmp(argv[i], "--", 2) == 0) {
+			positional = -1; // unknown option
+			break;
+		} else if (positional == 0) {
+			verticesFile = argv[i];
+			positional++;
+		} else if (positional == 1) {
+			distancesFile = argv[i];
+			positional++;
+		} else {
+			positional = -1; // too many arguments
+			break;
+		}
+	}
+	if (positional != 2 || expectedQueries < 0 || selfCheckQueries < 0 || ingestThreads < 0 || ingestThreads > INGEST_MAX_PARSERS) {
+		fprintf(stderr, "Usage: %s [--query-log=<file>] [--engine=<name>|auto] [--expected-queries=<n>] [--label-mem-cap=<MiB>] [--mem-budget=<subsystem>=<bytes>]... [--ingest-threads=<n>] [--self-check[=<n>]] <vertices> <distances>\n", argv[0]);
+		return 1;
+	}
+	if (strcmp(engineName, "auto") != 0 && engine_find(engineName) == NULL) {
+		fprintf(stderr, "Unknown engine %s; available: auto", engineName);
+		for (int i = 0; i < engine_count(); i++) {
+			fprintf(stderr, ", %s", engine_at(i)->name);
+		}
+		fprintf(stderr, "\n");
 		return 1;
 	}
-	const char *verticesFile = argv[1];
-	const char *distancesFile = argv[2];
 
 	Graph *graph = NULL;
-	if (!load_vertices(verticesFile, &graph) || graph == NULL) {
-		fprintf(stderr, "Failed to load vertices from %s\n", verticesFile);
-		return 1;
+	NameIndex *names = NULL; // only the pipelined ingest builds it up front
+	if (ingestThreads > 0) {
+		IngestStats ingest;
+		if (!ingest_graph(verticesFile, distancesFile, ingestThreads, &graph, &names, &ingest)) {
+			fprintf(stderr, "Failed to load graph from %s and %s\n", verticesFile, distancesFile);
+			return 1;
+		}
+		ingest_report(&ingest, stdout);
+	} else {
+		// Sequential reference loader
+		if (!load_vertices(verticesFile, &graph) || graph == NULL) {
+			fprintf(stderr, "Failed to load vertices from %s\n", verticesFile);
+			return 1;
+		}
+		if (!load_distances(graph, distancesFile)) {
+			fprintf(stderr, "Failed to load distances from %s\n", distancesFile);
+			free_graph(graph);
+			return 1;
+		}
+	}
+	EdgeCompaction compaction;
+	compact_edges(graph, &compaction);
+	report_compaction(&compaction);
+	if (selfCheckQueries > 0) {
+		int mismatches = engine_self_check(graph, selfCheckQueries, 12345u, stdout);
+		name_index_free(names);
+		free_graph(graph);
+		if (mismatches != 0) {
+			fprintf(stderr, "Engine self-check failed\n");
+			return 1;
+		}
+		printf("Engine self-check passed\n");
+		return 0;
 	}
-	if (!load_distances(graph, distancesFile)) {
-		fprintf(stderr, "Failed to load distances from %s\n", distancesFile);
+	GraphStore *store = graph_store_create(graph, names, engineName, expectedQueries, ingestThreads);
+	if (store == NULL) {
+		fprintf(stderr, "Failed to prepare engine %s\n", engineName);
+		name_index_free(names);
 		free_graph(graph);
 		return 1;
 	}
 
+	Session session;
+	memset(&session, 0, sizeof(session));
+	session.store = store;
+	session.readerSlot = graph_store_register_reader(store);
+	if (session.readerSlot < 0) {
+		fprintf(stderr, "Failed to register a graph reader\n");
+		graph_store_free(store);
+		return 1;
+	}
+	const GraphVersion *initial = graph_store_enter(store, session.readerSlot);
+	if (strcmp(engineName, "auto") == 0) {
+		printf("Routing engine: auto -> %s\n", initial->engine->name);
+	}
+	report_engine(initial);
+	mem_report(initial->graph->numVertices, initial->graph->numEdges, 0, stdout);
+	graph_store_exit(store, session.readerSlot);
+	snprintf(session.verticesFile, sizeof(session.verticesFile), "%s", verticesFile);
+	snprintf(session.distancesFile, sizeof(session.distancesFile), "%s", distancesFile);
+	if (queryLogFile != NULL) {
+		session.log = query_log_open(queryLogFile);
+		if (session.log == NULL) {
+			fprintf(stderr, "Failed to open query log %s\n", queryLogFile);
+			graph_store_unregister_reader(store, session.readerSlot);
+			graph_store_free(store);
+			return 1;
+		}
+	}
+
+	// No SA_RESTART: a SIGHUP interrupts the blocking read so the reload starts promptly
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = handle_sighup;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGHUP, &action, NULL);
+
 	print_welcome();
 
 	char input[1024];
 	while (1) {
+		report_reload(&session);
+		if (reloadRequested) {
+			reloadRequested = 0;
+			start_reload(&session, session.verticesFile, session.distancesFile);
+		}
 		prompt();
 		if (fgets(input, sizeof(input), stdin) == NULL) {
+			if (reloadRequested && ferror(stdin)) {
+				// Read interrupted by SIGHUP -> start the reload and prompt again
+				clearerr(stdin);
+				printf("\n");
+				continue;
+			}
 			// EOF -> exit
 			printf("Goodbye!\n");
 			break;
@@ -142,29 +734,61 @@ int main(int argc, char **argv) {
 
 		// Use sscanf to capture up to 3 tokens
 		tokenCount = sscanf(input, "%511s %511s %511s", cmd, arg1, arg2);
+		if (tokenCount == 1 && strcmp(cmd, "exit") == 0) {
+			printf("Goodbye!\n");
+			break;
+		}
+		if (tokenCount == 3 && strcmp(cmd, "reload") == 0) {
+			start_reload(&session, arg1, arg2);
+			continue;
+		}
+
+		// Every other command reads the graph: pin the active version until it finishes
+		const GraphVersion *version = graph_store_enter(store, session.readerSlot);
+		if (!bind_version(&session, version)) {
+			graph_store_exit(store, session.readerSlot);
+			fprintf(stderr, "Failed to allocate search workspace\n");
+			continue;
+		}
 		if (tokenCount == 1) {
 			if (strcmp(cmd, "list") == 0) {
-				list_cities(graph);
+				handle_list(&session);
+			} else if (strcmp(cmd, "mem") == 0) {
+				handle_mem(&session);
 			} else if (strcmp(cmd, "help") == 0) {
 				print_help();
-			} else if (strcmp(cmd, "exit") == 0) {
-				printf("Goodbye!\n");
-				break;
 			} else {
 				printf("Invalid Command\n");
 				print_help();
 			}
+		} else if (tokenCount == 2 && strcmp(cmd, "list") == 0 && name_index_find(session.version->names, cmd) < 0) {
+			// A city named "list" keeps its path queries
+			handle_list_prefix(&session, arg1, NULL);
 		} else if (tokenCount == 2) {
 			// Two city names
-			handle_two_cities(graph, cmd, arg1);
+			handle_two_cities(&session, cmd, arg1);
+		} else if (tokenCount == 3 && strcmp(cmd, "list") == 0) {
+			handle_list_prefix(&session, arg1, arg2);
+		} else if (tokenCount == 3 && strcmp(cmd, "distance") == 0) {
+			handle_distance(&session, arg1, arg2);
+		} else if (tokenCount == 3 && strcmp(cmd, "within") == 0) {
+			handle_within(&session, arg1, arg2);
 		} else if (tokenCount >= 3) {
 			// Too many args
 			printf("Invalid Command\n");
 			print_help();
 		}
+		release_stale_workspace(&session);
+		graph_store_exit(store, session.readerSlot);
 	}
 
-	free_graph(graph);
+	// Let an in-flight reload finish so its result is reported and nothing leaks
+	graph_store_wait_reload(store);
+	report_reload(&session);
+	query_log_close(session.log);
+	search_workspace_free(session.ws);
+	graph_store_unregister_reader(store, session.readerSlot);
+	graph_store_free(store);
 	return 0;
 }
 
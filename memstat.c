@@ -0,0 +1,247 @@
+#include "memstat.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+/*
+ * Memory accounting
+ *
+ * Byte counters per subsystem, maintained by thin wrappers around the C
+ * allocator, plus optional budgets and a report used at startup and by the
+ * `mem` command.
+ */
+
+static atomic_size_t currentBytes[MEM_SUBSYSTEM_COUNT];
+static atomic_size_t peakBytes[MEM_SUBSYSTEM_COUNT];
+static atomic_size_t budgetBytes[MEM_SUBSYSTEM_COUNT];
+
+static const char *const SUBSYSTEM_NAMES[MEM_SUBSYSTEM_COUNT] = {
+	"names",
+	"adjacency",
+	"index",
+	"cache",
+	"scratch"
+};
+
+/*
+ * charge
+ * 	Add 'bytes' to a subsystem and raise its peak if needed.
+ */
+static void charge(MemSubsystem subsystem, size_t bytes) {
+	size_t now = atomic_fetch_add(&currentBytes[subsystem], bytes) + bytes;
+	size_t peak = atomic_load(&peakBytes[subsystem]);
+	while (now > peak && !atomic_compare_exchange_weak(&peakBytes[subsystem], &peak, now)) {
+		// 'peak' was reloaded by the failed exchange; retry
+	}
+}
+
+/*
+ * release
+ * 	Subtract 'bytes' from a subsystem.
+ */
+static void release(MemSubsystem subsystem, size_t bytes) {
+	atomic_fetch_sub(&currentBytes[subsystem], bytes);
+}
+
+/*
+ * mem_malloc
+ * 	malloc that charges 'size' bytes on success.
+ */
+void *mem_malloc(MemSubsystem subsystem, size_t size) {
+	void *ptr = malloc(size);
+	if (ptr != NULL) {
+		charge(subsystem, size);
+	}
+	return ptr;
+}
+
+/*
+ * mem_calloc
+ * 	calloc that charges count * size bytes on success.
+ */
+void *mem_calloc(MemSubsystem subsystem, size_t count, size_t size) {
+	void *ptr = calloc(count, size);
+	if (ptr != NULL) {
+		charge(subsystem, count * size);
+	}
+	return ptr;
+}
+
+/*
+ * mem_realloc
+ * 	realloc that moves the charge from oldSize to newSize on success. On
+ * 	failure the old block and its charge are left untouched.
+ */
+void *mem_realloc(MemSubsystem subsystem, void *ptr, size_t oldSize, size_t newSize) {
+	void *grown = realloc(ptr, newSize);
+	if (grown != NULL) {
+		release(subsystem, ptr != NULL ? oldSize : 0);
+		charge(subsystem, newSize);
+	}
+	return grown;
+}
+
+/*
+ * mem_free
+ * 	free that releases the 'size' bytes charged for 'ptr'. Safe with NULL.
+ */
+void mem_free(MemSubsystem subsystem, void *ptr, size_t size) {
+	if (ptr == NULL) {
+		return;
+	}
+	free(ptr);
+	release(subsystem, size);
+}
+
+/*
+ * mem_strdup
+ * 	strdup charged to 'subsystem'.
+ */
+char *mem_strdup(MemSubsystem subsystem, const char *source) {
+	if (source == NULL) {
+		return NULL;
+	}
+	size_t len = strlen(source);
+	char *copy = (char *)mem_malloc(subsystem, len + 1);
+	if (copy != NULL) {
+		memcpy(copy, source, len + 1);
+	}
+	return copy;
+}
+
+/*
+ * mem_strfree
+ * 	Release a string from mem_strdup. Safe with NULL.
+ */
+void mem_strfree(MemSubsystem subsystem, char *copy) {
+	if (copy == NULL) {
+		return;
+	}
+	mem_free(subsystem, copy, strlen(copy) + 1);
+}
+
+/*
+ * mem_grow_together
+ * 	Allocate every new block before touching the old ones, so a failure
+ * 	part-way leaves the arrays and their recorded sizes consistent.
+ */
+int mem_grow_together(MemSubsystem subsystem, void *const oldArrays[], void *newArrays[], int count, size_t oldSize, size_t newSize) {
+	for (int i = 0; i < count; i++) {
+		newArrays[i] = mem_malloc(subsystem, newSize);
+		if (newArrays[i] == NULL) {
+			while (i-- > 0) {
+				mem_free(subsystem, newArrays[i], newSize);
+			}
+			return 0;
+		}
+	}
+	for (int i = 0; i < count; i++) {
+		if (oldArrays[i] != NULL) {
+			memcpy(newArrays[i], oldArrays[i], oldSize < newSize ? oldSize : newSize);
+			mem_free(subsystem, oldArrays[i], oldSize);
+		}
+	}
+	return 1;
+}
+
+size_t mem_current(MemSubsystem subsystem) {
+	return atomic_load(&currentBytes[subsystem]);
+}
+
+size_t mem_peak(MemSubsystem subsystem) {
+	return atomic_load(&peakBytes[subsystem]);
+}
+
+const char *mem_subsystem_name(MemSubsystem subsystem) {
+	if (subsystem < 0 || subsystem >= MEM_SUBSYSTEM_COUNT) {
+		return "unknown";
+	}
+	return SUBSYSTEM_NAMES[subsystem];
+}
+
+/*
+ * mem_subsystem_from_name
+ * 	Reverse of mem_subsystem_name.
+ */
+int mem_subsystem_from_name(const char *name) {
+	if (name == NULL) {
+		return -1;
+	}
+	for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+		if (strcmp(SUBSYSTEM_NAMES[i], name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void mem_set_budget(MemSubsystem subsystem, size_t bytes) {
+	atomic_store(&budgetBytes[subsystem], bytes);
+}
+
+size_t mem_budget(MemSubsystem subsystem) {
+	return atomic_load(&budgetBytes[subsystem]);
+}
+
+/*
+ * mem_within_budget
+ * 	Check whether the subsystem can grow by 'extra' bytes.
+ */
+int mem_within_budget(MemSubsystem subsystem, size_t extra) {
+	size_t budget = mem_budget(subsystem);
+	return budget == 0 || mem_current(subsystem) + extra <= budget;
+}
+
+/*
+ * mem_peak_rss_kb
+ * 	Peak RSS from getrusage; ru_maxrss is KiB on Linux and bytes on macOS.
+ */
+long mem_peak_rss_kb(void) {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return -1;
+	}
+#ifdef __APPLE__
+	return (long)(usage.ru_maxrss / 1024);
+#else
+	return (long)usage.ru_maxrss;
+#endif
+}
+
+/*
+ * mem_report
+ * 	Print tracked bytes, bytes per city/edge and peak RSS.
+ */
+void mem_report(int numVertices, int numEdges, int verbose, FILE *out) {
+	if (out == NULL) {
+		return;
+	}
+	size_t total = 0;
+	for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+		total += mem_current((MemSubsystem)i);
+	}
+	double perVertex = numVertices > 0 ? (double)mem_current(MEM_NAMES) / numVertices : 0.0;
+	double perEdge = numEdges > 0 ? (double)mem_current(MEM_ADJACENCY) / numEdges : 0.0;
+	if (!verbose) {
+		fprintf(out, "Memory: %zu bytes tracked (names %.1f B/city, adjacency %.1f B/edge), peak RSS %ld KiB\n",
+			total, perVertex, perEdge, mem_peak_rss_kb());
+		return;
+	}
+	fprintf(out, "Memory by subsystem (current / peak / budget bytes):\n");
+	for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+		MemSubsystem subsystem = (MemSubsystem)i;
+		size_t budget = mem_budget(subsystem);
+		if (budget > 0) {
+			fprintf(out, "\t%-10s %12zu %12zu %12zu\n", mem_subsystem_name(subsystem),
+				mem_current(subsystem), mem_peak(subsystem), budget);
+		} else {
+			fprintf(out, "\t%-10s %12zu %12zu %12s\n", mem_subsystem_name(subsystem),
+				mem_current(subsystem), mem_peak(subsystem), "-");
+		}
+	}
+	fprintf(out, "\t%-10s %12zu\n", "total", total);
+	fprintf(out, "Cities: %d (%.1f bytes/city for names)\n", numVertices, perVertex);
+	fprintf(out, "Edges: %d (%.1f bytes/edge for adjacency)\n", numEdges, perEdge);
+	fprintf(out, "Peak RSS: %ld KiB\n", mem_peak_rss_kb());
+}
@@ -0,0 +1,66 @@
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Subsystems whose heap usage is accounted separately.
+typedef enum {
+	MEM_NAMES = 0,     // vertex name strings and the name pointer array
+	MEM_ADJACENCY,     // Graph struct, adjacency heads and Edge nodes
+	MEM_INDEX,         // name index, hub labels
+	MEM_CACHE,         // pooled search workspaces kept between queries
+	MEM_SCRATCH,       // per-query and per-build working memory
+	MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+// Allocation wrappers: identical to malloc/calloc/realloc/free, but charge
+// the bytes to 'subsystem'. Callers pass the size they allocated when
+// freeing or reallocating, so no per-block header is needed.
+// Counters are atomic; the wrappers are safe to call from any thread.
+void *mem_malloc(MemSubsystem subsystem, size_t size);
+void *mem_calloc(MemSubsystem subsystem, size_t count, size_t size);
+void *mem_realloc(MemSubsystem subsystem, void *ptr, size_t oldSize, size_t newSize);
+void mem_free(MemSubsystem subsystem, void *ptr, size_t size);
+
+// Heap copy of a NUL-terminated string charged to 'subsystem' (NULL on NULL
+// input or allocation failure), and its matching release, which recovers the
+// size from the string. mem_strfree is safe with NULL.
+char *mem_strdup(MemSubsystem subsystem, const char *source);
+void mem_strfree(MemSubsystem subsystem, char *copy);
+
+// Grows 'count' parallel arrays of 'oldSize' bytes each to 'newSize' bytes,
+// all or nothing: new blocks are allocated first and the old ones are copied
+// and freed only once every allocation succeeded. On success newArrays[i]
+// replaces oldArrays[i] (which may be NULL when oldSize is 0). On failure
+// the old arrays and the counters are left untouched.
+// Returns 1 on success, 0 on allocation failure.
+int mem_grow_together(MemSubsystem subsystem, void *const oldArrays[], void *newArrays[], int count, size_t oldSize, size_t newSize);
+
+// Current and peak bytes charged to a subsystem.
+size_t mem_current(MemSubsystem subsystem);
+size_t mem_peak(MemSubsystem subsystem);
+
+// Name used in reports and on the command line ("names", "cache", ...).
+const char *mem_subsystem_name(MemSubsystem subsystem);
+
+// Returns the subsystem with the given name, or -1 if none matches.
+int mem_subsystem_from_name(const char *name);
+
+// Optional budget per subsystem in bytes (0 = unlimited). Budgets are not
+// enforced by the allocator; subsystems that can shrink (caches) or fail
+// cleanly (indexes) consult mem_within_budget before growing.
+void mem_set_budget(MemSubsystem subsystem, size_t bytes);
+size_t mem_budget(MemSubsystem subsystem);
+
+// Returns 1 if 'extra' more bytes fit in the subsystem's budget.
+int mem_within_budget(MemSubsystem subsystem, size_t extra);
+
+// Peak resident set size of the process in KiB, or -1 if unavailable.
+long mem_peak_rss_kb(void);
+
+// Prints accounting for a graph with the given size.
+// verbose = 0: one summary line; verbose = 1: a per-subsystem table.
+void mem_report(int numVertices, int numEdges, int verbose, FILE *out);
+
+#endif
@@ -0,0 +1,277 @@
+#include "nameindex.h"
+
+#include "io.h"
+#include "memstat.h"
+/*
+ * Name index
+ *
+ * Sorted, compact index of city names: one contiguous string table plus
+ * sorted offset and vertex arrays. Supports exact lookup, prefix ranges,
+ * buffered listing, and did-you-mean suggestions.
+ */
+
+// Names longer than this are never offered as suggestions.
+#define SUGGEST_MAX_NAME_LENGTH 255
+
+// Upper bound on suggestions returned by one name_index_suggest call.
+#define SUGGEST_MAX_RESULTS 16
+
+/*
+ * NameEntry
+ * 	One vertex name, pointing into the graph, while the index is sorted.
+ */
+typedef struct {
+	const char *name;
+	int vertex;
+} NameEntry;
+
+/*
+ * compare_by_name
+ * 	qsort comparator: by name, then by vertex index so repeated names keep
+ * 	load order.
+ */
+static int compare_by_name(const void *a, const void *b) {
+	const NameEntry *x = (const NameEntry *)a;
+	const NameEntry *y = (const NameEntry *)b;
+	int cmp = strcmp(x->name, y->name);
+	if (cmp != 0) {
+		return cmp;
+	}
+	return x->vertex - y->vertex;
+}
+
+/*
+ * name_index_build
+ * 	Sort (name, vertex) entries and pack the names into one string table
+ * 	in that order.
+ *
+ * Returns:
+ * 	Pointer to NameIndex on success; NULL on invalid input or allocation
+ * 	failure.
+ */
+NameIndex *name_index_build(const Graph *graph) {
+	if (graph == NULL) {
+		return NULL;
+	}
+	NameIndex *index = (NameIndex *)mem_calloc(MEM_INDEX, 1, sizeof(NameIndex));
+	if (index == NULL) {
+		return NULL;
+	}
+	int count = 0;
+	size_t bytes = 0;
+	for (int i = 0; i < graph->numVertices; i++) {
+		if (graph->vertexNames[i] != NULL) {
+			count++;
+			bytes += strlen(graph->vertexNames[i]) + 1;
+		}
+	}
+	index->numNames = count;
+	index->stringBytes = bytes;
+	index->vertices = (int *)mem_malloc(MEM_INDEX, (size_t)(count > 0 ? count : 1) * sizeof(int));
+	index->offsets = (int *)mem_malloc(MEM_INDEX, (size_t)(count > 0 ? count : 1) * sizeof(int));
+	index->strings = (char *)mem_malloc(MEM_INDEX, bytes > 0 ? bytes : 1);
+	size_t entryBytes = (size_t)(count > 0 ? count : 1) * sizeof(NameEntry);
+	NameEntry *entries = (NameEntry *)mem_malloc(MEM_SCRATCH, entryBytes);
+	if (index->vertices == NULL || index->offsets == NULL || index->strings == NULL || entries == NULL) {
+		mem_free(MEM_SCRATCH, entries, entryBytes);
+		name_index_free(index);
+		return NULL;
+	}
+	int position = 0;
+	for (int i = 0; i < graph->numVertices; i++) {
+		if (graph->vertexNames[i] != NULL) {
+			entries[position].name = graph->vertexNames[i];
+			entries[position].vertex = i;
+			position++;
+		}
+	}
+	qsort(entries, (size_t)count, sizeof(NameEntry), compare_by_name);
+
+	size_t offset = 0;
+	for (int i = 0; i < count; i++) {
+		size_t len = strlen(entries[i].name) + 1;
+		memcpy(index->strings + offset, entries[i].name, len);
+		index->offsets[i] = (int)offset;
+		index->vertices[i] = entries[i].vertex;
+		offset += len;
+	}
+	mem_free(MEM_SCRATCH, entries, entryBytes);
+	return index;
+}
+
+/*
+ * name_index_free
+ * 	Release the index. Safe to call with NULL.
+ */
+void name_index_free(NameIndex *index) {
+	if (index == NULL) {
+		return;
+	}
+	size_t arrayBytes = (size_t)(index->numNames > 0 ? index->numNames : 1) * sizeof(int);
+	mem_free(MEM_INDEX, index->strings, index->stringBytes > 0 ? index->stringBytes : 1);
+	mem_free(MEM_INDEX, index->offsets, arrayBytes);
+	mem_free(MEM_INDEX, index->vertices, arrayBytes);
+	mem_free(MEM_INDEX, index, sizeof(NameIndex));
+}
+
+/*
+ * name_index_name_at
+ * 	Name at sorted 'position' (caller keeps it in range).
+ */
+const char *name_index_name_at(const NameIndex *index, int position) {
+	return index->strings + index->offsets[position];
+}
+
+/*
+ * lower_bound
+ * 	First sorted position whose name compares >= 'key' over its first
+ * 	'keyLen' characters (keyLen 0 compares whole names).
+ */
+static int lower_bound(const NameIndex *index, const char *key, size_t keyLen, int strictlyGreater) {
+	int lo = 0;
+	int hi = index->numNames;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		const char *name = name_index_name_at(index, mid);
+		int cmp = keyLen > 0 ? strncmp(name, key, keyLen) : strcmp(name, key);
+		if (cmp < 0 || (strictlyGreater && cmp == 0)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/*
+ * name_index_find
+ * 	Binary search for an exact name.
+ */
+int name_index_find(const NameIndex *index, const char *name) {
+	if (index == NULL || name == NULL) {
+		return -1;
+	}
+	int position = lower_bound(index, name, 0, 0);
+	if (position < index->numNames && strcmp(name_index_name_at(index, position), name) == 0) {
+		return index->vertices[position];
+	}
+	return -1;
+}
+
+/*
+ * name_index_prefix_range
+ * 	Two binary searches bracket the names that start with 'prefix'.
+ */
+int name_index_prefix_range(const NameIndex *index, const char *prefix, int *outFirst) {
+	if (index == NULL || prefix == NULL || outFirst == NULL) {
+		return 0;
+	}
+	size_t len = strlen(prefix);
+	if (len == 0) {
+		*outFirst = 0;
+		return index->numNames;
+	}
+	int first = lower_bound(index, prefix, len, 0);
+	int end = lower_bound(index, prefix, len, 1);
+	*outFirst = first;
+	return end - first;
+}
+
+/*
+ * edit_distance
+ * 	Levenshtein distance between a and b using two rolling rows.
+ * 	Both strings must be at most SUGGEST_MAX_NAME_LENGTH long.
+ */
+static int edit_distance(const char *a, size_t lenA, const char *b, size_t lenB) {
+	int rowA[SUGGEST_MAX_NAME_LENGTH + 1];
+	int rowB[SUGGEST_MAX_NAME_LENGTH + 1];
+	int *prev = rowA;
+	int *cur = rowB;
+	for (size_t j = 0; j <= lenB; j++) {
+		prev[j] = (int)j;
+	}
+	for (size_t i = 1; i <= lenA; i++) {
+		cur[0] = (int)i;
+		for (size_t j = 1; j <= lenB; j++) {
+			int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+			int best = prev[j - 1] + cost;
+			if (prev[j] + 1 < best) {
+				best = prev[j] + 1;
+			}
+			if (cur[j - 1] + 1 < best) {
+				best = cur[j - 1] + 1;
+			}
+			cur[j] = best;
+		}
+		int *tmp = prev;
+		prev = cur;
+		cur = tmp;
+	}
+	return prev[lenB];
+}
+
+/*
+ * name_index_suggest
+ * 	Score every name: 0 if it starts with 'name', else its edit distance.
+ * 	Keep the best 'maxSuggestions' within a length-dependent threshold.
+ * 	Linear in V, but only runs after a lookup has already missed.
+ */
+int name_index_suggest(const NameIndex *index, const char *name, int *outVertices, int maxSuggestions) {
+	if (index == NULL || name == NULL || outVertices == NULL || maxSuggestions <= 0) {
+		return 0;
+	}
+	size_t len = strlen(name);
+	if (len == 0 || len > SUGGEST_MAX_NAME_LENGTH) {
+		return 0;
+	}
+	if (maxSuggestions > SUGGEST_MAX_RESULTS) {
+		maxSuggestions = SUGGEST_MAX_RESULTS;
+	}
+	int threshold = len <= 4 ? 1 : 2 + (int)(len / 8);
+	int count = 0;
+	int scores[SUGGEST_MAX_RESULTS];
+	for (int i = 0; i < index->numNames; i++) {
+		const char *candidate = name_index_name_at(index, i);
+		size_t candidateLen = strlen(candidate);
+		int score;
+		if (strncmp(candidate, name, len) == 0) {
+			score = 0;
+		} else {
+			size_t diff = candidateLen > len ? candidateLen - len : len - candidateLen;
+			if (candidateLen > SUGGEST_MAX_NAME_LENGTH || (int)diff > threshold) {
+				continue;
+			}
+			score = edit_distance(name, len, candidate, candidateLen);
+		}
+		if (score > threshold || (count == maxSuggestions && score >= scores[count - 1])) {
+			continue;
+		}
+		// Insert in score order; ties keep alphabetical order
+		int pos = count < maxSuggestions ? count++ : count - 1;
+		while (pos > 0 && scores[pos - 1] > score) {
+			scores[pos] = scores[pos - 1];
+			outVertices[pos] = outVertices[pos - 1];
+			pos--;
+		}
+		scores[pos] = score;
+		outVertices[pos] = index->vertices[i];
+	}
+	return count;
+}
+
+/*
+ * name_index_write
+ * 	Write the names through a LineWriter instead of one formatted write
+ * 	per line.
+ */
+void name_index_write(const NameIndex *index, int first, int count, FILE *out) {
+	if (index == NULL || out == NULL || first < 0 || count <= 0 || first + count > index->numNames) {
+		return;
+	}
+	LineWriter writer;
+	line_writer_init(&writer, out);
+	for (int i = first; i < first + count; i++) {
+		line_writer_put(&writer, name_index_name_at(index, i));
+	}
+	line_writer_flush(&writer);
+}
@@ -0,0 +1,50 @@
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <stdio.h>
+
+#include "graph.h"
+
+// Sorted city-name index over one graph.
+// All names are copied, in sorted order, into a single contiguous string
+// table; position i of the index refers to the i-th name in sort order.
+// Lookups and prefix ranges are binary searches: O(log V + k).
+typedef struct {
+	int numNames;
+	char *strings;        // NUL-terminated names, back to back
+	size_t stringBytes;
+	int *offsets;         // sorted position -> offset into strings
+	int *vertices;        // sorted position -> vertex index
+} NameIndex;
+
+// Builds the index from the graph's vertex names (NULL names are skipped).
+// Returns NULL on invalid input or allocation failure.
+NameIndex *name_index_build(const Graph *graph);
+void name_index_free(NameIndex *index);
+
+// Returns the vertex index for 'name' (the lowest one if the name repeats),
+// or -1 if not found.
+int name_index_find(const NameIndex *index, const char *name);
+
+// Finds the sorted positions whose names start with 'prefix'.
+// Returns the number of matches k and sets *outFirst to the first position;
+// positions *outFirst .. *outFirst + k - 1 all match. An empty prefix
+// matches every name.
+int name_index_prefix_range(const NameIndex *index, const char *prefix, int *outFirst);
+
+// Name stored at a sorted position.
+const char *name_index_name_at(const NameIndex *index, int position);
+
+// name_index_suggest:
+//   Did-you-mean candidates for a name that was not found: names within a
+//   small edit distance or starting with 'name', closest first.
+// Returns:
+//   number of vertex indices written to outVertices (at most maxSuggestions,
+//   which is capped at 16).
+int name_index_suggest(const NameIndex *index, const char *name, int *outVertices, int maxSuggestions);
+
+// Writes the names at sorted positions first .. first + count - 1, one per
+// line, through a single buffer flushed with fwrite.
+void name_index_write(const NameIndex *index, int first, int count, FILE *out);
+
+#endif
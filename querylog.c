@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+#include "querylog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/*
+ * Query log
+ *
+ * Records REPL queries as JSON lines so real workloads can be replayed
+ * against other builds. The format is fixed (field order never changes),
+ * which lets the reader use a single sscanf instead of a JSON parser; prefix
+ * listings append one escaped "prefix" string after the fixed fields.
+ */
+
+#define QUERY_LOG_FORMAT "{\"ts\":%lld,\"cmd\":\"%s\",\"src\":%d,\"dst\":%d,\"budget\":%d,\"latency_us\":%lld,\"results\":%d"
+#define QUERY_LOG_SCAN "{\"ts\":%lld,\"cmd\":\"%15[^\"]\",\"src\":%d,\"dst\":%d,\"budget\":%d,\"latency_us\":%lld,\"results\":%d%n"
+#define QUERY_LOG_PREFIX_KEY ",\"prefix\":\""
+
+/*
+ * query_log_open
+ * 	Open 'path' in append mode so several runs accumulate in one file.
+ *
+ * Returns:
+ * 	Pointer to QueryLog on success; NULL on invalid input or open failure.
+ */
+QueryLog *query_log_open(const char *path) {
+	if (path == NULL) {
+		return NULL;
+	}
+	QueryLog *log = (QueryLog *)malloc(sizeof(QueryLog));
+	if (log == NULL) {
+		return NULL;
+	}
+	log->fp = fopen(path, "a");
+	if (log->fp == NULL) {
+		free(log);
+		return NULL;
+	}
+	return log;
+}
+
+/*
+ * query_log_close
+ * 	Flush and close the log. Safe to call with NULL.
+ */
+void query_log_close(QueryLog *log) {
+	if (log == NULL) {
+		return;
+	}
+	fclose(log->fp);
+	free(log);
+}
+
+/*
+ * query_log_write
+ * 	Append 'record' as one JSON line and flush it.
+ */
+void query_log_write(QueryLog *log, const QueryLogRecord *record) {
+	if (log == NULL || record == NULL) {
+		return;
+	}
+	fprintf(log->fp, QUERY_LOG_FORMAT, record->timestampMs, record->command, record->src,
+		record->dst, record->budget, record->latencyUs, record->resultSize);
+	if (record->prefix[0] != '\0') {
+		fputs(QUERY_LOG_PREFIX_KEY, log->fp);
+		for (const char *c = record->prefix; *c != '\0'; c++) {
+			if (*c == '"' || *c == '\\') {
+				fputc('\\', log->fp);
+			}
+			fputc(*c, log->fp);
+		}
+		fputc('"', log->fp);
+	}
+	fputs("}\n", log->fp);
+	fflush(log->fp);
+}
+
+/*
+ * query_log_parse_line
+ * 	Decode one line produced by query_log_write into 'outRecord'.
+ *
+ * Returns:
+ * 	1 on success, 0 if the line does not match the log format.
+ */
+int query_log_parse_line(const char *line, QueryLogRecord *outRecord) {
+	if (line == NULL || outRecord == NULL) {
+		return 0;
+	}
+	memset(outRecord, 0, sizeof(QueryLogRecord));
+	int consumed = 0;
+	int scanned = sscanf(line, QUERY_LOG_SCAN, &outRecord->timestampMs, outRecord->command,
+		&outRecord->src, &outRecord->dst, &outRecord->budget, &outRecord->latencyUs,
+		&outRecord->resultSize, &consumed);
+	if (scanned != 7) {
+		return 0;
+	}
+	const char *rest = line + consumed;
+	size_t keyLen = strlen(QUERY_LOG_PREFIX_KEY);
+	if (strncmp(rest, QUERY_LOG_PREFIX_KEY, keyLen) == 0) {
+		size_t len = 0;
+		for (rest += keyLen; *rest != '"'; rest++) {
+			if (*rest == '\\') {
+				rest++;
+			}
+			if (*rest == '\0' || len + 1 >= sizeof(outRecord->prefix)) {
+				return 0;
+			}
+			outRecord->prefix[len++] = *rest;
+		}
+		outRecord->prefix[len] = '\0';
+		rest++;
+	}
+	return *rest == '}';
+}
+
+/*
+ * query_log_now_us
+ * 	Current CLOCK_MONOTONIC time in microseconds.
+ */
+long long query_log_now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/*
+ * query_log_wall_ms
+ * 	Current CLOCK_REALTIME time in milliseconds since the Unix epoch.
+ */
+long long query_log_wall_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,45 @@
+#ifndef QUERYLOG_H
+#define QUERYLOG_H
+
+#include <stdio.h>
+
+// Longest prefix a record can carry, terminator included (REPL tokens are
+// at most 511 characters).
+#define QUERY_LOG_MAX_PREFIX 512
+
+// One recorded REPL query. Unused vertex/budget fields are -1.
+typedef struct {
+	long long timestampMs;   // wall-clock time the query started (ms since epoch)
+	char command[16];        // "path", "distance", "within", "list" or "prefix"
+	int src;
+	int dst;
+	int budget;              // distance budget for within, page number for prefix
+	long long latencyUs;     // time spent answering the query
+	int resultSize;          // path length, 1 for a found distance, cities in range, or cities listed or matched
+	char prefix[QUERY_LOG_MAX_PREFIX];  // name prefix for prefix, else empty
+} QueryLogRecord;
+
+// Append-only query log, one JSON object per line.
+typedef struct {
+	FILE *fp;
+} QueryLog;
+
+// Opens (creating if needed) 'path' for appending. Returns NULL on failure.
+QueryLog *query_log_open(const char *path);
+void query_log_close(QueryLog *log);
+
+// Appends one record and flushes it so a crash loses at most that line.
+// Safe to call with a NULL log (no-op).
+void query_log_write(QueryLog *log, const QueryLogRecord *record);
+
+// Parses one line written by query_log_write.
+// Returns 1 on success, 0 if the line is malformed.
+int query_log_parse_line(const char *line, QueryLogRecord *outRecord);
+
+// Monotonic clock in microseconds, for measuring latencies.
+long long query_log_now_us(void);
+
+// Wall clock in milliseconds since the Unix epoch, for record timestamps.
+long long query_log_wall_ms(void);
+
+#endif
@@ -0,0 +1,391 @@
+/*
+ * Query replay - load-test driver for recorded query logs
+ *
+ * Loads the same graph files as the interactive program, reads a query log
+ * written by `map.out --query-log=<file>`, and replays its path and range
+ * queries against the engine from several threads at a configurable rate.
+ * Reports throughput, latency percentiles and any answers whose result size
+ * differs from the recording, so two builds can be compared on real traffic.
+ *
+ * Usage:
+ *   ./replay.out [--rate=<qps>] [--concurrency=<n>] [--repeat=<n>]
+ *                [--engine=<name>|auto] [--ingest-threads=<n>]
+ *                <vertices> <distances> <query-log>
+ *
+ * --rate=0 (the default) replays as fast as possible. Path and distance
+ * queries go through the selected routing engine (default: dijkstra) and
+ * prefix listings through the sorted name index, without printing the
+ * names. Full city listings only print, so they are counted as skipped,
+ * along with malformed lines and vertices outside the graph.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "graph.h"
+#include "io.h"
+#include "dijkstra.h"
+#include "search.h"
+#include "querylog.h"
+#include "engine.h"
+#include "ingest.h"
+#include "nameindex.h"
+
+#define MAX_CONCURRENCY 256
+
+/*
+ * ReplayContext
+ * 	Shared state for the replay worker threads. Workers claim records by
+ * 	atomically incrementing 'next'; query i is scheduled at
+ * 	startUs + i / rate seconds when a rate is set.
+ */
+typedef struct {
+	const Graph *graph;
+	const NameIndex *names;
+	const RoutingEngine *engine;
+	void *engineState;
+	const QueryLogRecord *records;
+	int recordCount;
+	int totalQueries;        // recordCount * repeat
+	double rate;             // queries per second, 0 for unthrottled
+	long long startUs;
+	long long *latencies;    // size totalQueries
+	atomic_int next;
+	atomic_int mismatches;
+	atomic_int failures;
+} ReplayContext;
+
+/*
+ * sleep_until_us
+ * 	Block until the monotonic clock reaches 'targetUs'.
+ */
+static void sleep_until_us(long long targetUs) {
+	long long now = query_log_now_us();
+	while (now < targetUs) {
+		long long remaining = targetUs - now;
+		struct timespec ts;
+		ts.tv_sec = (time_t)(remaining / 1000000LL);
+		ts.tv_nsec = (long)((remaining % 1000000LL) * 1000LL);
+		nanosleep(&ts, NULL);
+		now = query_log_now_us();
+	}
+}
+
+/*
+ * run_record
+ * 	Execute one recorded query.
+ *
+ * Returns:
+ * 	The result size (path length, 1 for a found distance, cities in range
+ * 	or cities matching the prefix), or -1 on failure.
+ */
+static int run_record(const ReplayContext *ctx, SearchWorkspace *ws, const QueryLogRecord *record) {
+	if (strcmp(record->command, "distance") == 0) {
+		int total = 0;
+		int found = engine_distance(ctx->engine, ctx->engineState, ctx->graph, record->src, record->dst, &total);
+		if (found == DIJKSTRA_TOO_LONG) {
+			long long wideTotal = 0;
+			found = dijkstra_distance_wide(ctx->graph, record->src, record->dst, &wideTotal);
+		}
+		return found < 0 ? -1 : (found > 0 ? 1 : 0);
+	}
+	if (strcmp(record->command, "prefix") == 0) {
+		int first = 0;
+		return name_index_prefix_range(ctx->names, record->prefix, &first);
+	}
+	if (strcmp(record->command, "path") == 0) {
+		int *path = NULL;
+		int pathLen = 0;
+		int total = 0;
+		int found = ctx->engine->query(ctx->engineState, ctx->graph, record->src, record->dst, &path, &pathLen, &total);
+		if (found == DIJKSTRA_TOO_LONG) {
+			// Same 64-bit retry as the interactive program
+			long long wideTotal = 0;
+			found = dijkstra_shortest_path_wide(ctx->graph, record->src, record->dst, &path, &pathLen, &wideTotal);
+		}
+		if (found > 0) {
+			free(path);
+		}
+		if (found < 0) {
+			return -1;
+		}
+		return found > 0 ? pathLen : 0;
+	}
+	RangeResult *results = NULL;
+	int count = 0;
+	int status = search_within(ws, record->src, record->budget, &results, &count);
+	free(results);
+	return status > 0 ? count : -1;
+}
+
+/*
+ * replay_worker
+ * 	Thread body: claim queries until the log is exhausted, pacing them to
+ * 	the configured rate and recording each latency.
+ */
+static void *replay_worker(void *arg) {
+	ReplayContext *ctx = (ReplayContext *)arg;
+	SearchWorkspace *ws = search_workspace_create(ctx->graph, MEM_SCRATCH);
+	if (ws == NULL) {
+		atomic_fetch_add(&ctx->failures, 1);
+		return NULL;
+	}
+	while (1) {
+		int i = atomic_fetch_add(&ctx->next, 1);
+		if (i >= ctx->totalQueries) {
+			break;
+		}
+		if (ctx->rate > 0) {
+			sleep_until_us(ctx->startUs + (long long)((double)i * 1000000.0 / ctx->rate));
+		}
+		const QueryLogRecord *record = &ctx->records[i % ctx->recordCount];
+		long long begin = query_log_now_us();
+		int resultSize = run_record(ctx, ws, record);
+		ctx->latencies[i] = query_log_now_us() - begin;
+		if (resultSize < 0) {
+			atomic_fetch_add(&ctx->failures, 1);
+		} else if (resultSize != record->resultSize) {
+			atomic_fetch_add(&ctx->mismatches, 1);
+		}
+	}
+	search_workspace_free(ws);
+	return NULL;
+}
+
+/*
+ * load_records
+ * 	Read replayable records (path, distance and within queries whose
+ * 	vertices exist in 'graph', and prefix listings) from 'logPath'.
+ *
+ * Returns:
+ * 	1 on success with the records, count and skipped count set, 0 on failure.
+ */
+static int load_records(const char *logPath, const Graph *graph, QueryLogRecord **outRecords, int *outCount, int *outSkipped) {
+	FILE *fp = fopen(logPath, "r");
+	if (fp == NULL) {
+		return 0;
+	}
+	QueryLogRecord *records = NULL;
+	int count = 0;
+	int capacity = 0;
+	int skipped = 0;
+	char buffer[2048]; // room for a 511-character prefix with every byte escaped
+	while (fgets(buffer, sizeof(buffer), fp) != NULL) {
+		QueryLogRecord record;
+		if (!query_log_parse_line(buffer, &record)) {
+			skipped++;
+			continue;
+		}
+		int isPair = strcmp(record.command, "path") == 0 || strcmp(record.command, "distance") == 0;
+		int isWithin = strcmp(record.command, "within") == 0;
+		int isPrefix = strcmp(record.command, "prefix") == 0;
+		int n = graph->numVertices;
+		int valid;
+		if (isPrefix) {
+			valid = record.prefix[0] != '\0' && record.budget >= 1;
+		} else {
+			valid = (isPair || isWithin) && record.src >= 0 && record.src < n
+				&& (!isPair || (record.dst >= 0 && record.dst < n))
+				&& (!isWithin || record.budget >= 0);
+		}
+		if (!valid) {
+			skipped++;
+			continue;
+		}
+		if (count >= capacity) {
+			int newCapacity = capacity > 0 ? capacity * 2 : 64;
+			QueryLogRecord *tmp = (QueryLogRecord *)realloc(records, (size_t)newCapacity * sizeof(QueryLogRecord));
+			if (tmp == NULL) {
+				free(records);
+				fclose(fp);
+				return 0;
+			}
+			records = tmp;
+			capacity = newCapacity;
+		}
+		records[count++] = record;
+	}
+	fclose(fp);
+	*outRecords = records;
+	*outCount = count;
+	*outSkipped = skipped;
+	return 1;
+}
+
+/*
+ * compare_latency
+ * 	qsort comparator for ascending long long latencies.
+ */
+static int compare_latency(const void *a, const void *b) {
+	long long x = *(const long long *)a;
+	long long y = *(const long long *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * percentile
+ * 	Nearest-rank percentile of an ascending array of 'count' latencies.
+ */
+static long long percentile(const long long *sorted, int count, double p) {
+	int rank = (int)(p * count + 0.999999);
+	if (rank < 1) {
+		rank = 1;
+	}
+	if (rank > count) {
+		rank = count;
+	}
+	return sorted[rank - 1];
+}
+
+/*
+ * main
+ * 	Parse options, load the graph and log, run the replay and print the
+ * 	report.
+ *
+ * Returns:
+ * 	0 when every query ran, 1 on usage/loading errors or failed queries.
+ */
+int main(int argc, char **argv) {
+	double rate = 0;
+	int concurrency = 1;
+	int repeat = 1;
+	const char *engineName = "dijkstra";
+	int ingestThreads = INGEST_DEFAULT_PARSERS;
+	const char *files[3] = { NULL, NULL, NULL };
+	int positional = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--rate=", 7) == 0) {
+			rate = atof(argv[i] + 7);
+		} else if (strncmp(argv[i], "--concurrency=", 14) == 0) {
+			concurrency = atoi(argv[i] + 14);
+		} else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+			repeat = atoi(argv[i] + 9);
+		} else if (strncmp(argv[i], "--engine=", 9) == 0) {
+			engineName = argv[i] + 9;
+		} else if (strncmp(argv[i], "--ingest-threads=", 17) == 0) {
+			ingestThreads = atoi(argv[i] + 17);
+		} else if (strncmp(argv[i], "--", 2) != 0 && positional < 3) {
+			files[positional++] = argv[i];
+		} else {
+			positional = -1;
+			break;
+		}
+	}
+	if (positional != 3 || rate < 0 || concurrency < 1 || concurrency > MAX_CONCURRENCY || repeat < 1
+		|| ingestThreads < 0 || ingestThreads > INGEST_MAX_PARSERS) {
+		fprintf(stderr, "Usage: %s [--rate=<qps>] [--concurrency=<n>] [--repeat=<n>] [--engine=<name>|auto] [--ingest-threads=<n>] <vertices> <distances> <query-log>\n", argv[0]);
+		return 1;
+	}
+
+	// Same pipelined load and edge compaction as the server, so replayed answers match the recording
+	Graph *graph = NULL;
+	NameIndex *names = NULL;
+	if (!load_graph(files[0], files[1], ingestThreads, &graph, &names, NULL)) {
+		fprintf(stderr, "Failed to load graph from %s and %s\n", files[0], files[1]);
+		return 1;
+	}
+	const RoutingEngine *engine = engine_resolve(engineName, graph, 0);
+	void *engineState = engine != NULL ? engine->prepare(graph) : NULL;
+	if (engineState == NULL) {
+		fprintf(stderr, "Failed to prepare engine %s\n", engineName);
+		name_index_free(names);
+		free_graph(graph);
+		return 1;
+	}
+	if (!(engine->capabilities & ENGINE_CAP_THREAD_SAFE)) {
+		concurrency = 1;
+	}
+	QueryLogRecord *records = NULL;
+	int recordCount = 0;
+	int skipped = 0;
+	if (!load_records(files[2], graph, &records, &recordCount, &skipped)) {
+		fprintf(stderr, "Failed to read query log %s\n", files[2]);
+		engine->free_state(engineState);
+		name_index_free(names);
+		free_graph(graph);
+		return 1;
+	}
+	if (recordCount == 0) {
+		fprintf(stderr, "No replayable queries in %s (skipped %d)\n", files[2], skipped);
+		free(records);
+		engine->free_state(engineState);
+		name_index_free(names);
+		free_graph(graph);
+		return 1;
+	}
+	if (repeat > INT_MAX / recordCount) {
+		fprintf(stderr, "--repeat=%d is too large for %d records\n", repeat, recordCount);
+		free(records);
+		engine->free_state(engineState);
+		name_index_free(names);
+		free_graph(graph);
+		return 1;
+	}
+
+	ReplayContext ctx;
+	ctx.graph = graph;
+	ctx.names = names;
+	ctx.engine = engine;
+	ctx.engineState = engineState;
+	ctx.records = records;
+	ctx.recordCount = recordCount;
+	ctx.totalQueries = recordCount * repeat;
+	ctx.rate = rate;
+	ctx.latencies = (long long *)calloc((size_t)ctx.totalQueries, sizeof(long long));
+	atomic_init(&ctx.next, 0);
+	atomic_init(&ctx.mismatches, 0);
+	atomic_init(&ctx.failures, 0);
+	if (ctx.latencies == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		free(records);
+		engine->free_state(engineState);
+		name_index_free(names);
+		free_graph(graph);
+		return 1;
+	}
+
+	pthread_t threads[MAX_CONCURRENCY];
+	int started = 0;
+	ctx.startUs = query_log_now_us();
+	for (int i = 0; i < concurrency; i++) {
+		if (pthread_create(&threads[i], NULL, replay_worker, &ctx) != 0) {
+			break;
+		}
+		started++;
+	}
+	if (started == 0) {
+		// No worker could start; run the replay on this thread instead
+		replay_worker(&ctx);
+	}
+	for (int i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	long long elapsedUs = query_log_now_us() - ctx.startUs;
+
+	qsort(ctx.latencies, (size_t)ctx.totalQueries, sizeof(long long), compare_latency);
+	double seconds = elapsedUs > 0 ? (double)elapsedUs / 1000000.0 : 1e-6;
+	printf("Engine: %s\n", engine->name);
+	printf("Replayed %d queries (%d records x %d, skipped %d) with concurrency %d in %.3f ms\n",
+		ctx.totalQueries, recordCount, repeat, skipped, started > 0 ? started : 1, (double)elapsedUs / 1000.0);
+	printf("Throughput: %.1f queries/s\n", (double)ctx.totalQueries / seconds);
+	printf("Latency (us): p50 %lld p90 %lld p99 %lld max %lld\n",
+		percentile(ctx.latencies, ctx.totalQueries, 0.50),
+		percentile(ctx.latencies, ctx.totalQueries, 0.90),
+		percentile(ctx.latencies, ctx.totalQueries, 0.99),
+		ctx.latencies[ctx.totalQueries - 1]);
+	printf("Result mismatches: %d\n", atomic_load(&ctx.mismatches));
+	printf("Failures: %d\n", atomic_load(&ctx.failures));
+
+	int failures = atomic_load(&ctx.failures);
+	free(ctx.latencies);
+	free(records);
+	engine->free_state(engineState);
+	name_index_free(names);
+	free_graph(graph);
+	return failures > 0 ? 1 : 0;
+}
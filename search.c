@@ -0,0 +1,439 @@
+#include "search.h"
+
+#include "memstat.h"
+/*
+ * Search workspace
+ *
+ * Heap-based Dijkstra searches (bounded range queries, point-to-point
+ * paths and distances, and visitor-driven searches) that reuse their scratch
+ * memory across queries. Only the vertices a query touches are reset
+ * afterwards, which keeps bounded searches proportional to the size of
+ * their result instead of the size of the graph. The search loops are
+ * generated from dijkstra_kernel.h; this file supplies the workspace
+ * storage they run in.
+ */
+
+/*
+ * gate_reserve
+ * 	Ask the workspace's gate, if any, for 'bytes' more.
+ */
+static int gate_reserve(SearchWorkspace *ws, size_t bytes) {
+	return ws->reserve == NULL || ws->reserve(ws->gateContext, bytes);
+}
+
+/*
+ * gate_release
+ * 	Hand 'bytes' back to the workspace's gate, if any.
+ */
+static void gate_release(SearchWorkspace *ws, size_t bytes) {
+	if (ws->release != NULL) {
+		ws->release(ws->gateContext, bytes);
+	}
+}
+
+/*
+ * ensure_capacity
+ * 	Grow the touched list so it can hold at least 'needed' elements.
+ *
+ * Returns:
+ * 	1 on success, 0 on allocation failure or a refused growth (the old
+ * 	array is left intact).
+ */
+static int ensure_capacity(SearchWorkspace *ws, int needed) {
+	if (needed <= ws->touchedCapacity) {
+		return 1;
+	}
+	int newCapacity = ws->touchedCapacity > 0 ? ws->touchedCapacity : 16;
+	while (newCapacity < needed) {
+		newCapacity *= 2;
+	}
+	size_t oldBytes = (size_t)ws->touchedCapacity * sizeof(int);
+	size_t newBytes = (size_t)newCapacity * sizeof(int);
+	if (!gate_reserve(ws, newBytes)) {
+		return 0;
+	}
+	int *tmp = (int *)mem_realloc(ws->account, ws->touched, oldBytes, newBytes);
+	if (tmp == NULL) {
+		gate_release(ws, newBytes);
+		return 0;
+	}
+	gate_release(ws, oldBytes);
+	ws->touched = tmp;
+	ws->touchedCapacity = newCapacity;
+	return 1;
+}
+
+/*
+ * grow_heap
+ * 	Make room for one more heap entry.
+ *
+ * Returns:
+ * 	1 on success, 0 on allocation failure or a refused growth.
+ */
+static int grow_heap(SearchWorkspace *ws) {
+	if (ws->heapSize < ws->heapCapacity) {
+		return 1;
+	}
+	// Both arrays share one capacity; grow them together or not at all
+	int newCapacity = ws->heapCapacity > 0 ? ws->heapCapacity * 2 : 16;
+	size_t oldBytes = (size_t)ws->heapCapacity * sizeof(int);
+	size_t newBytes = (size_t)newCapacity * sizeof(int);
+	if (!gate_reserve(ws, 2 * newBytes)) {
+		return 0;
+	}
+	void *oldArrays[2] = { ws->heapVertex, ws->heapKey };
+	void *newArrays[2];
+	if (!mem_grow_together(ws->account, oldArrays, newArrays, 2, oldBytes, newBytes)) {
+		gate_release(ws, 2 * newBytes);
+		return 0;
+	}
+	gate_release(ws, 2 * oldBytes);
+	ws->heapVertex = (int *)newArrays[0];
+	ws->heapKey = (int *)newArrays[1];
+	ws->heapCapacity = newCapacity;
+	return 1;
+}
+
+/*
+ * ensure_previous
+ * 	Allocate the predecessor array on the first search that records paths,
+ * 	so workspaces used only for distances never hold one.
+ *
+ * Returns:
+ * 	1 on success, 0 on allocation failure.
+ */
+static int ensure_previous(SearchWorkspace *ws) {
+	if (ws->previous == NULL) {
+		ws->previous = (int *)mem_malloc(ws->account, (size_t)ws->numVertices * sizeof(int));
+	}
+	return ws->previous != NULL;
+}
+
+/*
+ * touch
+ * 	Set distance[v], remembering v so it can be reset after the query.
+ *
+ * Returns:
+ * 	1 on success, 0 on allocation failure.
+ */
+static int touch(SearchWorkspace *ws, int v, int dist) {
+	if (ws->distance[v] >= INF_DISTANCE) {
+		if (!ensure_capacity(ws, ws->touchedCount + 1)) {
+			return 0;
+		}
+		ws->touched[ws->touchedCount++] = v;
+	}
+	ws->distance[v] = dist;
+	return 1;
+}
+
+/*
+ * reset_workspace
+ * 	Restore every touched distance to infinity and empty the heap.
+ */
+static void reset_workspace(SearchWorkspace *ws) {
+	for (int i = 0; i < ws->touchedCount; i++) {
+		ws->distance[ws->touched[i]] = INF_DISTANCE;
+	}
+	ws->touchedCount = 0;
+	ws->heapSize = 0;
+}
+
+/*
+ * RangeCollector
+ * 	Visitor context of a range search: where settled cities are appended.
+ */
+typedef struct {
+	int src;
+	RangeResult **results;
+	int *count;
+	int *capacity;
+} RangeCollector;
+
+/*
+ * collect_in_range
+ * 	Range visitor: append every settled city except the origin.
+ *
+ * Returns:
+ * 	1 to keep expanding, -1 on allocation failure.
+ */
+static int collect_in_range(void *context, int vertex, int distance, int parent) {
+	(void)parent;
+	RangeCollector *collector = (RangeCollector *)context;
+	if (vertex == collector->src) {
+		return 1;
+	}
+	RangeResult **results = collector->results;
+	int *count = collector->count;
+	if (*count >= *collector->capacity) {
+		int newCapacity = *collector->capacity > 0 ? *collector->capacity * 2 : 16;
+		RangeResult *tmp = (RangeResult *)realloc(*results, (size_t)newCapacity * sizeof(RangeResult));
+		if (tmp == NULL) {
+			return -1;
+		}
+		*results = tmp;
+		*collector->capacity = newCapacity;
+	}
+	(*results)[*count].vertex = vertex;
+	(*results)[*count].distance = distance;
+	(*count)++;
+	return 1;
+}
+
+/*
+ * VisitorBinding
+ * 	Context of search_settle: the caller's visitor and its context.
+ */
+typedef struct {
+	SearchVisitor visit;
+	void *context;
+} VisitorBinding;
+
+/*
+ * forward_visit
+ * 	search_settle visitor: call the caller's visitor.
+ */
+static int forward_visit(void *context, int vertex, int distance, int parent) {
+	const VisitorBinding *binding = (const VisitorBinding *)context;
+	return binding->visit(binding->context, vertex, distance, parent);
+}
+
+// Range queries: bounded, distance only; no previous[] is allocated or written
+#define KERNEL_NAME kernel_range
+#define KERNEL_DIST int
+#define KERNEL_INF INF_DISTANCE
+#define KERNEL_HEAP 1
+#define KERNEL_PATH 0
+#define KERNEL_WORKSPACE 1
+#define KERNEL_VISIT collect_in_range
+#include "dijkstra_kernel.h"
+
+// Heap engine: point to point with the path
+#define KERNEL_NAME kernel_path
+#define KERNEL_DIST int
+#define KERNEL_INF INF_DISTANCE
+#define KERNEL_HEAP 1
+#define KERNEL_PATH 1
+#define KERNEL_WORKSPACE 1
+#include "dijkstra_kernel.h"
+
+// Heap engine distance lookups: point to point, no previous[]
+#define KERNEL_NAME kernel_distance
+#define KERNEL_DIST int
+#define KERNEL_INF INF_DISTANCE
+#define KERNEL_HEAP 1
+#define KERNEL_PATH 0
+#define KERNEL_WORKSPACE 1
+#include "dijkstra_kernel.h"
+
+// search_settle: bounded, with predecessors for the visitor
+#define KERNEL_NAME kernel_settle
+#define KERNEL_DIST int
+#define KERNEL_INF INF_DISTANCE
+#define KERNEL_HEAP 1
+#define KERNEL_PATH 1
+#define KERNEL_WORKSPACE 1
+#define KERNEL_VISIT forward_visit
+#include "dijkstra_kernel.h"
+
+/*
+ * run_bounded
+ * 	Range search from 'src', appending settled cities in non-decreasing
+ * 	distance order. Vertices are only pushed when their tentative distance
+ * 	is within 'budget', so the search ends when the heap drains.
+ *
+ * Returns:
+ * 	1 on success, 0 on allocation failure. The workspace is reset either way.
+ */
+static int run_bounded(SearchWorkspace *ws, int src, int budget, RangeResult **results, int *count, int *capacity) {
+	RangeCollector collector = { src, results, count, capacity };
+	// No int distance reaches INF_DISTANCE, so larger budgets change nothing
+	int bound = budget < INF_DISTANCE ? budget : INF_DISTANCE - 1;
+	return kernel_range(ws, src, bound, &collector) > 0;
+}
+
+/*
+ * search_workspace_create
+ * 	Allocate a workspace for 'graph' with every distance set to infinity.
+ *
+ * Returns:
+ * 	Pointer to SearchWorkspace on success; NULL on invalid input or
+ * 	allocation failure.
+ */
+SearchWorkspace *search_workspace_create(const Graph *graph, MemSubsystem account) {
+	if (graph == NULL || graph->numVertices <= 0) {
+		return NULL;
+	}
+	SearchWorkspace *ws = (SearchWorkspace *)mem_calloc(account, 1, sizeof(SearchWorkspace));
+	if (ws == NULL) {
+		return NULL;
+	}
+	size_t arrayBytes = (size_t)graph->numVertices * sizeof(int);
+	ws->graph = graph;
+	ws->numVertices = graph->numVertices;
+	ws->account = account;
+	ws->distance = (int *)mem_malloc(account, arrayBytes);
+	if (ws->distance == NULL) {
+		mem_free(account, ws, sizeof(SearchWorkspace));
+		return NULL;
+	}
+	for (int i = 0; i < graph->numVertices; i++) {
+		ws->distance[i] = INF_DISTANCE;
+	}
+	return ws;
+}
+
+/*
+ * search_workspace_free
+ * 	Release all memory owned by the workspace. Safe to call with NULL.
+ */
+void search_workspace_free(SearchWorkspace *ws) {
+	if (ws == NULL) {
+		return;
+	}
+	size_t arrayBytes = (size_t)ws->numVertices * sizeof(int);
+	mem_free(ws->account, ws->distance, arrayBytes);
+	mem_free(ws->account, ws->previous, arrayBytes);
+	mem_free(ws->account, ws->touched, (size_t)ws->touchedCapacity * sizeof(int));
+	mem_free(ws->account, ws->heapVertex, (size_t)ws->heapCapacity * sizeof(int));
+	mem_free(ws->account, ws->heapKey, (size_t)ws->heapCapacity * sizeof(int));
+	mem_free(ws->account, ws, sizeof(SearchWorkspace));
+}
+
+/*
+ * search_workspace_set_gate
+ * 	Install (or, with NULLs, remove) the growth gate.
+ */
+void search_workspace_set_gate(SearchWorkspace *ws, int (*reserve)(void *context, size_t bytes), void (*release)(void *context, size_t bytes), void *context) {
+	if (ws == NULL) {
+		return;
+	}
+	ws->reserve = reserve;
+	ws->release = release;
+	ws->gateContext = context;
+}
+
+/*
+ * search_within
+ * 	Collect every city within 'budget' of 'src', nearest first.
+ *
+ * Returns:
+ * 	1 on success, -1 on invalid input or allocation failure.
+ *
+ * Notes:
+ * 	Caller owns and must free(*outResults).
+ */
+int search_within(SearchWorkspace *ws, int src, int budget, RangeResult **outResults, int *outCount) {
+	if (ws == NULL || outResults == NULL || outCount == NULL) {
+		return -1;
+	}
+	if (src < 0 || src >= ws->graph->numVertices || budget < 0) {
+		return -1;
+	}
+	RangeResult *results = NULL;
+	int count = 0;
+	int capacity = 0;
+	if (!run_bounded(ws, src, budget, &results, &count, &capacity)) {
+		free(results);
+		return -1;
+	}
+	*outResults = results;
+	*outCount = count;
+	return 1;
+}
+
+/*
+ * search_shortest_path
+ * 	Heap-based Dijkstra from 'src' that stops once 'dst' is settled, then
+ * 	walks previous[] back from dst to build the path.
+ *
+ * Returns:
+ * 	1 if a path is found, 0 if dst is unreachable, DIJKSTRA_TOO_LONG if a
+ * 	relaxation reached INF_DISTANCE before dst was found, -1 on invalid
+ * 	input or allocation failure.
+ *
+ * Notes:
+ * 	Caller owns and must free(*outPath) when return value > 0.
+ */
+int search_shortest_path(SearchWorkspace *ws, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance) {
+	if (ws == NULL || outPath == NULL || outPathLen == NULL || outTotalDistance == NULL) {
+		return -1;
+	}
+	int n = ws->graph->numVertices;
+	if (src < 0 || src >= n || dst < 0 || dst >= n) {
+		return -1;
+	}
+	return kernel_path(ws, src, dst, outTotalDistance, outPath, outPathLen);
+}
+
+/*
+ * search_distance
+ * 	search_shortest_path without the path: the search never allocates or
+ * 	writes previous[].
+ *
+ * Returns:
+ * 	Same codes as search_shortest_path.
+ */
+int search_distance(SearchWorkspace *ws, int src, int dst, int *outTotalDistance) {
+	if (ws == NULL || outTotalDistance == NULL) {
+		return -1;
+	}
+	int n = ws->graph->numVertices;
+	if (src < 0 || src >= n || dst < 0 || dst >= n) {
+		return -1;
+	}
+	return kernel_distance(ws, src, dst, outTotalDistance);
+}
+
+/*
+ * search_settle
+ * 	Bounded search that reports every settled vertex to 'visit'.
+ *
+ * Returns:
+ * 	1 or 2 when done (see search.h), -1 on failure.
+ */
+int search_settle(SearchWorkspace *ws, int src, int bound, SearchVisitor visit, void *context) {
+	if (ws == NULL || visit == NULL || src < 0 || src >= ws->graph->numVertices || bound < 0 || bound >= INF_DISTANCE) {
+		return -1;
+	}
+	VisitorBinding binding = { visit, context };
+	return kernel_settle(ws, src, bound, &binding);
+}
+
+/*
+ * search_within_batch
+ * 	Run search_within for each origin/budget pair, packing all results into
+ * 	one array indexed by an offsets table of size count + 1.
+ *
+ * Returns:
+ * 	1 on success, -1 on invalid input or allocation failure.
+ */
+int search_within_batch(SearchWorkspace *ws, const int *origins, const int *budgets, int count, RangeResult **outResults, int **outOffsets) {
+	if (ws == NULL || origins == NULL || budgets == NULL || count < 0 || outResults == NULL || outOffsets == NULL) {
+		return -1;
+	}
+	for (int i = 0; i < count; i++) {
+		if (origins[i] < 0 || origins[i] >= ws->graph->numVertices || budgets[i] < 0) {
+			return -1;
+		}
+	}
+	int *offsets = (int *)malloc((size_t)(count + 1) * sizeof(int));
+	if (offsets == NULL) {
+		return -1;
+	}
+	RangeResult *results = NULL;
+	int total = 0;
+	int capacity = 0;
+	for (int i = 0; i < count; i++) {
+		offsets[i] = total;
+		if (!run_bounded(ws, origins[i], budgets[i], &results, &total, &capacity)) {
+			free(results);
+			free(offsets);
+			return -1;
+		}
+	}
+	offsets[count] = total;
+	*outResults = results;
+	*outOffsets = offsets;
+	return 1;
+}
@@ -0,0 +1,108 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "graph.h"
+#include "dijkstra.h"
+#include "memstat.h"
+
+// One city reached by a bounded search, with its shortest distance from the
+// origin.
+typedef struct {
+	int vertex;
+	int distance;
+} RangeResult;
+
+// Reusable state for heap-based searches over a single graph.
+// The distance array is allocated once per graph and kept at "infinite";
+// each search records which entries it touched and resets only those, so a
+// query costs time proportional to the part of the graph it explores rather
+// than to the number of vertices. The searches themselves are instances of
+// the kernel in dijkstra_kernel.h.
+typedef struct {
+	const Graph *graph;
+	int numVertices;     // size of the per-vertex arrays; freeing never reads graph
+	int *distance;       // size numVertices, INF_DISTANCE when untouched
+	int *previous;       // size numVertices once a search needs predecessors, else NULL
+	int *touched;        // vertices whose distance was written this query
+	int touchedCount;
+	int touchedCapacity;
+	int *heapVertex;     // binary min-heap with lazy deletion
+	int *heapKey;
+	int heapSize;
+	int heapCapacity;
+	MemSubsystem account;  // subsystem charged for this workspace's memory
+	int (*reserve)(void *context, size_t bytes);  // optional growth gate, see search_workspace_set_gate
+	void (*release)(void *context, size_t bytes);
+	void *gateContext;
+} SearchWorkspace;
+
+// Called by search_settle for each settled vertex, in non-decreasing
+// distance order, with its predecessor on a shortest path (-1 for the
+// origin). Returns 1 to relax the vertex's edges, 0 to settle it without
+// relaxing them, -1 to abort the search.
+typedef int (*SearchVisitor)(void *context, int vertex, int distance, int parent);
+
+// Allocates a workspace for 'graph', charging its memory (including later
+// growth of the heap and touched list) to 'account': MEM_SCRATCH for a
+// workspace owned by one session or thread, MEM_CACHE for pooled ones.
+// Returns NULL on allocation failure.
+// The workspace must not be used once its graph is freed, but freeing it is
+// always safe (search_workspace_free never reads the graph). It is not
+// thread-safe; use one workspace per thread.
+SearchWorkspace *search_workspace_create(const Graph *graph, MemSubsystem account);
+void search_workspace_free(SearchWorkspace *ws);
+
+// Routes the growth of the touched list and heap through a caller's memory
+// cap: 'reserve' is asked for the bytes of each new array before it is
+// allocated and may refuse (the search then fails with -1); 'release' gets
+// back the bytes of every array freed after a successful growth. Bytes held
+// before the gate is set are not reported.
+void search_workspace_set_gate(SearchWorkspace *ws, int (*reserve)(void *context, size_t bytes), void (*release)(void *context, size_t bytes), void *context);
+
+// search_within:
+//   Finds every city whose shortest distance from src is at most 'budget'.
+//   The search stops as soon as the smallest frontier distance exceeds the
+//   budget. Results exclude src itself and are sorted by distance.
+// Parameters:
+//   ws          - workspace created for the graph being searched
+//   src         - origin vertex index
+//   budget      - maximum distance (inclusive, must be >= 0)
+//   outResults  - receives a malloc'd array (NULL when outCount is 0)
+//   outCount    - receives the number of results
+// Returns:
+//   1 on success, -1 on invalid input or allocation failure.
+int search_within(SearchWorkspace *ws, int src, int budget, RangeResult **outResults, int *outCount);
+
+// search_shortest_path:
+//   Point-to-point shortest path using a binary heap, O((V + E) log V) in
+//   the worst case but stopping as soon as dst is settled. Same parameters
+//   and return contract as dijkstra_shortest_path (DIJKSTRA_TOO_LONG
+//   included); caller frees *outPath.
+int search_shortest_path(SearchWorkspace *ws, int src, int dst, int **outPath, int *outPathLen, int *outTotalDistance);
+
+// search_distance:
+//   Shortest distance only, with the same search and return codes as
+//   search_shortest_path; no predecessors are recorded, so a workspace used
+//   only for distances never allocates them.
+int search_distance(SearchWorkspace *ws, int src, int dst, int *outTotalDistance);
+
+// search_settle:
+//   Dijkstra from src that hands every vertex within 'bound' of it, src
+//   included, to 'visit' (see SearchVisitor). Used by searches that prune or
+//   record as they go, such as the hub-label build.
+// Returns:
+//   1 when done, 2 when done but edges leading past 'bound' were skipped,
+//  -1 on invalid input, allocation failure, a refused growth or when
+//   'visit' aborted.
+int search_settle(SearchWorkspace *ws, int src, int bound, SearchVisitor visit, void *context);
+
+// search_within_batch:
+//   Answers 'count' origin/budget pairs with the same workspace so scratch
+//   memory is shared across queries. Results for query i are stored at
+//   (*outResults)[(*outOffsets)[i]] .. (*outResults)[(*outOffsets)[i + 1] - 1].
+// Returns:
+//   1 on success, -1 on invalid input or allocation failure.
+//   Caller owns and must free(*outResults) and free(*outOffsets).
+int search_within_batch(SearchWorkspace *ws, const int *origins, const int *budgets, int count, RangeResult **outResults, int **outOffsets);
+
+#endif
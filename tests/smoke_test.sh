@@ -9,20 +9,111 @@ make >/dev/null
 
 echo "[2/3] Small dataset checks..."
 OUT_SMALL="$(printf "what do i do?\nlist\na f\nf a\na x\nhelp\nexit\n" | ./map.out vertices.txt distances.txt)"
-echo "$OUT_SMALL" | grep -q "Invalid Command"
-echo "$OUT_SMALL" | grep -q "^b$"
-echo "$OUT_SMALL" | grep -q "^x$"
-echo "$OUT_SMALL" | grep -q "Path Found..."
-echo "$OUT_SMALL" | grep -q "Total Distance: 10"
-echo "$OUT_SMALL" | grep -q "Path Not Found..."
-echo "$OUT_SMALL" | grep -q "Commands:"
-echo "$OUT_SMALL" | grep -q "Goodbye!"
+grep -q "Invalid Command" <<< "$OUT_SMALL"
+grep -q "^b$" <<< "$OUT_SMALL"
+grep -q "^x$" <<< "$OUT_SMALL"
+grep -q "Path Found..." <<< "$OUT_SMALL"
+grep -q "Total Distance: 10" <<< "$OUT_SMALL"
+grep -q "Path Not Found..." <<< "$OUT_SMALL"
+grep -q "Commands:" <<< "$OUT_SMALL"
+grep -q "Goodbye!" <<< "$OUT_SMALL"
+
+OUT_RANGE="$(printf "within a 5\nwithin a 0\nwithin a -1\nexit\n" | ./map.out vertices.txt distances.txt)"
+grep -q "Cities Within Range..." <<< "$OUT_RANGE"
+grep -q "$(printf '\td 3')" <<< "$OUT_RANGE"
+grep -q "$(printf '\tg 5')" <<< "$OUT_RANGE"
+if grep -q "$(printf '\te ')" <<< "$OUT_RANGE"; then
+	echo "within returned a city beyond its budget"
+	exit 1
+fi
+grep -q "No Cities Within Range..." <<< "$OUT_RANGE"
+grep -q "Invalid Command" <<< "$OUT_RANGE"
+
+QUERY_LOG="$(mktemp)"
+trap 'rm -f "$QUERY_LOG"' EXIT
+printf "a f\nwithin a 5\nlist a\ndistance a f\nexit\n" | ./map.out --query-log="$QUERY_LOG" vertices.txt distances.txt >/dev/null
+grep -q '"cmd":"path","src":0,"dst":5' "$QUERY_LOG"
+grep -q '"cmd":"within","src":0,"dst":-1,"budget":5' "$QUERY_LOG"
+grep -q '"cmd":"distance","src":0,"dst":5,"budget":-1,.*"results":1}' "$QUERY_LOG"
+grep -q '"cmd":"prefix","src":-1,"dst":-1,"budget":1,.*"prefix":"a"}' "$QUERY_LOG"
+OUT_REPLAY="$(./replay.out --concurrency=2 --repeat=10 vertices.txt distances.txt "$QUERY_LOG")"
+grep -q "Replayed 40 queries" <<< "$OUT_REPLAY"
+grep -q "Latency (us): p50" <<< "$OUT_REPLAY"
+grep -q "Result mismatches: 0" <<< "$OUT_REPLAY"
+
+OUT_RELOAD="$( (printf "reload city_list.dat city_distances.dat\n"; sleep 1; printf "paris rome\nreload missing.txt missing.txt\nexit\n") | ./map.out vertices.txt distances.txt)"
+grep -q "Reloading graph from city_list.dat and city_distances.dat..." <<< "$OUT_RELOAD"
+grep -q "Graph reloaded (generation 2, 12 cities)" <<< "$OUT_RELOAD"
+grep -q "Total Distance: 1118" <<< "$OUT_RELOAD"
+grep -q "Reload failed; still using the previous graph" <<< "$OUT_RELOAD"
+
+OUT_ENGINE="$(printf "a f\nexit\n" | ./map.out --engine=heap vertices.txt distances.txt)"
+grep -q "Total Distance: 10" <<< "$OUT_ENGINE"
+OUT_AUTO="$(printf "exit\n" | ./map.out --engine=auto vertices.txt distances.txt)"
+grep -q "Routing engine: auto -> dijkstra" <<< "$OUT_AUTO"
+OUT_LABELS="$(printf "a f\nexit\n" | ./map.out --engine=hub-label vertices.txt distances.txt)"
+grep -q "Hub labels: " <<< "$OUT_LABELS"
+grep -q "Total Distance: 10" <<< "$OUT_LABELS"
+OUT_CHECK="$(./map.out --self-check=100 vertices.txt distances.txt)"
+grep -q "range search: 100 batched queries, 0 mismatches" <<< "$OUT_CHECK"
+grep -q "wide search: .* 0 mismatches" <<< "$OUT_CHECK"
+grep -q "Engine self-check passed" <<< "$OUT_CHECK"
+
+DUPLICATE_EDGES="$(mktemp)"
+LONG_EDGES="$(mktemp)"
+LIST_VERTICES="$(mktemp)"
+LIST_EDGES="$(mktemp)"
+trap 'rm -f "$QUERY_LOG" "$DUPLICATE_EDGES" "$LONG_EDGES" "$LIST_VERTICES" "$LIST_EDGES"' EXIT
+{ cat distances.txt; printf "\nf e 3\nc f 20\na a 4\n"; } > "$DUPLICATE_EDGES"
+OUT_COMPACT="$(printf "a f\nexit\n" | ./map.out vertices.txt "$DUPLICATE_EDGES")"
+grep -q "Edge compaction removed 1 duplicate, 1 parallel and 1 self-loop edges" <<< "$OUT_COMPACT"
+grep -q "Total Distance: 10" <<< "$OUT_COMPACT"
+
+# A city named "list" keeps its two-city queries
+{ cat vertices.txt; printf "\nlist\n"; } > "$LIST_VERTICES"
+{ cat distances.txt; printf "\nlist a 7\n"; } > "$LIST_EDGES"
+OUT_LIST_CITY="$(printf "list a\nexit\n" | ./map.out "$LIST_VERTICES" "$LIST_EDGES")"
+grep -q "Total Distance: 7" <<< "$OUT_LIST_CITY"
+
+printf "a b 600000000\nb c 600000000\n" > "$LONG_EDGES"
+OUT_LONG="$(printf "a c\ndistance a c\nexit\n" | ./map.out --engine=heap vertices.txt "$LONG_EDGES")"
+[ "$(grep -c "Total Distance: 1200000000" <<< "$OUT_LONG")" -eq 2 ]
+OUT_LONG_CHECK="$(./map.out --self-check=100 vertices.txt "$LONG_EDGES")"
+grep -q "Engine self-check passed" <<< "$OUT_LONG_CHECK"
+
+OUT_MEM="$(printf "a f\nmem\nexit\n" | ./map.out --engine=heap --mem-budget=cache=1 vertices.txt distances.txt)"
+grep -q "^Memory: [0-9]* bytes tracked" <<< "$OUT_MEM"
+grep -q "Memory by subsystem" <<< "$OUT_MEM"
+grep -q "Total Distance: 10" <<< "$OUT_MEM"
+grep -Eq "$(printf '^\tcache +[0-9]+ +[0-9]+ +1$')" <<< "$OUT_MEM"
+grep -q "Peak RSS: " <<< "$OUT_MEM"
+for BAD_OPTION in --mem-budget=cache=99999999999999G --mem-budget=cache=-1 --label-mem-cap=-1 --label-mem-cap=abc; do
+	if printf "exit\n" | ./map.out "$BAD_OPTION" vertices.txt distances.txt >/dev/null 2>&1; then
+		echo "accepted $BAD_OPTION"
+		exit 1
+	fi
+done
 
 echo "[3/3] Large dataset checks..."
-OUT_LARGE="$(printf "list\nexit\n" | ./map.out city_list.dat city_distances.dat)"
-echo "$OUT_LARGE" | grep -q "Welcome to the shortest path finder"
-echo "$OUT_LARGE" | grep -q "paris"
-echo "$OUT_LARGE" | grep -q "Goodbye!"
+OUT_LARGE="$(printf "list\nlist p\nparsi rome\nexit\n" | ./map.out city_list.dat city_distances.dat)"
+grep -q "Welcome to the shortest path finder" <<< "$OUT_LARGE"
+grep -q "paris" <<< "$OUT_LARGE"
+grep -q 'Cities Matching "p" (1-2 of 2):' <<< "$OUT_LARGE"
+grep -q "^prague$" <<< "$OUT_LARGE"
+grep -q 'Unknown city "parsi". Did you mean: paris?' <<< "$OUT_LARGE"
+grep -q "Goodbye!" <<< "$OUT_LARGE"
+
+OUT_INGEST="$(printf "paris rome\nexit\n" | ./map.out --ingest-threads=3 city_list.dat city_distances.dat)"
+grep -q "Ingest: 12 cities, 48 edges (0 lines skipped)" <<< "$OUT_INGEST"
+grep -q "Total Distance: 1118" <<< "$OUT_INGEST"
+OUT_SEQUENTIAL="$(printf "paris rome\nexit\n" | ./map.out --ingest-threads=0 city_list.dat city_distances.dat)"
+grep -q "Total Distance: 1118" <<< "$OUT_SEQUENTIAL"
+
+OUT_LARGE_CHECK="$(./map.out --self-check=300 cities_large.txt cities_distances_large.txt)"
+grep -q "Engine self-check passed" <<< "$OUT_LARGE_CHECK"
+# The final index fits in what is left of 4K, but the build peaks well above it
+OUT_CAPPED="$(printf "exit\n" | ./map.out --engine=hub-label --mem-budget=index=4K cities_large.txt cities_distances_large.txt 2>&1 || true)"
+grep -q "Hub label build exceeds the index memory cap" <<< "$OUT_CAPPED"
 
 echo "All smoke tests passed."
 